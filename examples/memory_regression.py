@@ -0,0 +1,160 @@
+#!/usr/bin/python3
+# memory_regression.py
+#
+# -------------------------------------------------
+# Copyright 2015-2022 Dominic Ford
+#
+# This file is part of StarCharter.
+#
+# StarCharter is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# StarCharter is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+# -------------------------------------------------
+
+"""
+Render a long sequence of star charts from a single configuration file, and check that the resident memory of the
+StarCharter process stays flat, rather than growing with each chart it renders. This relies on /proc, so only works
+on Linux.
+"""
+
+import argparse
+import logging
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# Template configuration file, to which we append one CHART section per star chart
+template_defaults = """
+DEFAULTS
+ra_central=5.5
+dec_central=4.0
+angular_width=40.0
+mag_min=6
+width=10.0
+aspect=1.41421356
+ra_dec_lines=1
+constellation_boundaries=1
+constellation_sticks=1
+coords=ra_dec
+projection=gnomonic
+star_names=1
+constellation_names=1
+plot_galaxy_map=1
+plot_ecliptic=1
+ephemeris_engine=builtin
+draw_ephemeris=jupiter,2459000.5,2459365.5
+"""
+
+template_chart = """
+CHART
+output_filename={output_dir}/chart_{index:04d}.png
+"""
+
+
+def read_rss(pid):
+    """
+    Read the resident set size of a process.
+
+    :param pid:
+        The process ID to query
+    :return:
+        Resident set size, kB, or None if the process has exited
+    """
+    try:
+        with open("/proc/{}/status".format(pid)) as f:
+            for line in f:
+                if line.startswith("VmRSS:"):
+                    return int(line.split()[1])
+    except (IOError, ValueError):
+        pass
+    return None
+
+
+def check_memory(binary, chart_count, tolerance):
+    """
+    Render <chart_count> star charts in one StarCharter process, sampling its resident memory as it goes.
+
+    :param binary:
+        The path to the StarCharter binary
+    :param chart_count:
+        The number of star charts to render
+    :param tolerance:
+        The fractional growth in peak memory usage between the first and second halves of the run which we allow
+    :return:
+        True if memory usage stayed flat
+    """
+    with tempfile.TemporaryDirectory() as output_dir:
+        # Create configuration file
+        config_filename = os.path.join(output_dir, "memory_regression.sch")
+        with open(config_filename, "w") as out:
+            out.write(template_defaults)
+            for index in range(chart_count):
+                out.write(template_chart.format(output_dir=output_dir, index=index))
+
+        # Sample the peak memory usage while rendering each chart, judging progress by the number of charts which
+        # have been written to disk
+        peak_rss = [0] * chart_count
+        process = subprocess.Popen([binary, config_filename])
+        while process.poll() is None:
+            rss = read_rss(process.pid)
+            charts_done = len([f for f in os.listdir(output_dir) if f.endswith(".png")])
+            if (rss is not None) and (charts_done < chart_count):
+                peak_rss[charts_done] = max(peak_rss[charts_done], rss)
+            time.sleep(0.02)
+
+        if process.returncode != 0:
+            logging.error("StarCharter exited with status {}".format(process.returncode))
+            return False
+
+    # Ignore the first few charts, while caches such as the galaxy map are populated, and then compare the peak memory
+    # usage in the first and second halves of the run
+    warm_up = max(1, chart_count // 10)
+    first_half = max(peak_rss[warm_up:chart_count // 2])
+    second_half = max(peak_rss[chart_count // 2:])
+    logging.info("Peak RSS: {:d} kB over charts {:d}-{:d}; {:d} kB over charts {:d}-{:d}".format(
+        first_half, warm_up, chart_count // 2 - 1, second_half, chart_count // 2, chart_count - 1))
+
+    if (first_half == 0) or (second_half == 0):
+        logging.error("Charts rendered too quickly to sample memory usage; increase the number of charts")
+        return False
+    if second_half > first_half * (1 + tolerance):
+        logging.error("Memory usage grew by {:.1f}% over the run".format((second_half / first_half - 1) * 100))
+        return False
+    return True
+
+
+# Do it right away if we're run as a script
+if __name__ == "__main__":
+    # Read command-line arguments
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--binary', dest='binary', default="../bin/starchart.bin",
+                        help="The path to the StarCharter binary")
+    parser.add_argument('--charts', dest='chart_count', type=int, default=500,
+                        help="The number of star charts to render")
+    parser.add_argument('--tolerance', dest='tolerance', type=float, default=0.05,
+                        help="The fractional growth in peak memory usage which is allowed")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO,
+                        stream=sys.stdout,
+                        format='[%(asctime)s] %(levelname)s:%(filename)s:%(message)s',
+                        datefmt='%d/%m/%Y %H:%M:%S')
+    logger = logging.getLogger(__name__)
+    logger.info(__doc__.strip())
+
+    if args.chart_count < 20:
+        logger.error("At least 20 charts are needed to measure memory usage")
+        sys.exit(1)
+
+    sys.exit(0 if check_memory(binary=args.binary, chart_count=args.chart_count, tolerance=args.tolerance) else 1)
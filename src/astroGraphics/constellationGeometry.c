@@ -0,0 +1,586 @@
+// constellationGeometry.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// Compile the text files describing the boundaries, stick figures and name positions of the constellations into a
+// single binary file. Each piece of geometry is stored with the cap on the celestial sphere which encloses it, so
+// that constellations which fall outside the field of view of a chart can be skipped without projecting them.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+
+#include "astroGraphics/constellationGeometry.h"
+#include "coreUtils/asciiDouble.h"
+#include "coreUtils/errorReport.h"
+#include "mathsTools/projection.h"
+#include "settings/chart_config.h"
+
+// Binary file format version number
+static const int constellation_geometry_binary_format_version = 3;
+
+// Filenames
+static const char *binary_constellation_geometry = SRCDIR "../data/constellations/constellation_geometry.bin";
+
+//! The factor by which we enlarge the field of view when testing whether constellations fall within it, to allow
+//! for lines which are not straight in the projection
+#define CONSTELLATION_FIELD_MARGIN 1.2
+
+//! The three-letter abbreviations and English names of the constellations, indexed by numeric constellation id
+static const char *constellation_table[CONSTELLATION_COUNT][2] = {
+    {"AND", "Andromeda"}, {"ANT", "Antlia"}, {"APS", "Apus"}, {"AQR", "Aquarius"}, {"AQL", "Aquila"}, {"ARA", "Ara"},
+    {"ARI", "Aries"}, {"AUR", "Auriga"}, {"BOO", "Bootes"}, {"CAE", "Caelum"}, {"CAM", "Camelopardalis"},
+    {"CNC", "Cancer"}, {"CVN", "Canes Venatici"}, {"CMA", "Canis Major"}, {"CMI", "Canis Minor"},
+    {"CAP", "Capricornus"}, {"CAR", "Carina"}, {"CAS", "Cassiopeia"}, {"CEN", "Centaurus"}, {"CEP", "Cepheus"},
+    {"CET", "Cetus"}, {"CHA", "Chamaeleon"}, {"CIR", "Circinus"}, {"COL", "Columba"}, {"COM", "Coma Berenices"},
+    {"CRA", "Corona Australis"}, {"CRB", "Corona Borealis"}, {"CRV", "Corvus"}, {"CRT", "Crater"}, {"CRU", "Crux"},
+    {"CYG", "Cygnus"}, {"DEL", "Delphinus"}, {"DOR", "Dorado"}, {"DRA", "Draco"}, {"EQU", "Equuleus"},
+    {"ERI", "Eridanus"}, {"FOR", "Fornax"}, {"GEM", "Gemini"}, {"GRU", "Grus"}, {"HER", "Hercules"},
+    {"HOR", "Horologium"}, {"HYA", "Hydra"}, {"HYI", "Hydrus"}, {"IND", "Indus"}, {"LAC", "Lacerta"}, {"LEO", "Leo"},
+    {"LMI", "Leo Minor"}, {"LEP", "Lepus"}, {"LIB", "Libra"}, {"LUP", "Lupus"}, {"LYN", "Lynx"}, {"LYR", "Lyra"},
+    {"MEN", "Mensa"}, {"MIC", "Microscopium"}, {"MON", "Monoceros"}, {"MUS", "Musca"}, {"NOR", "Norma"},
+    {"OCT", "Octans"}, {"OPH", "Ophiuchus"}, {"ORI", "Orion"}, {"PAV", "Pavo"}, {"PEG", "Pegasus"}, {"PER", "Perseus"},
+    {"PHE", "Phoenix"}, {"PIC", "Pictor"}, {"PSC", "Pisces"}, {"PSA", "Piscis Austrinus"}, {"PUP", "Puppis"},
+    {"PYX", "Pyxis"}, {"RET", "Reticulum"}, {"SGE", "Sagitta"}, {"SGR", "Sagittarius"}, {"SCO", "Scorpius"},
+    {"SCL", "Sculptor"}, {"SCT", "Scutum"}, {"SER", "Serpens"}, {"SEX", "Sextans"}, {"TAU", "Taurus"},
+    {"TEL", "Telescopium"}, {"TRI", "Triangulum"}, {"TRA", "Triangulum Australe"}, {"TUC", "Tucana"},
+    {"UMA", "Ursa Major"}, {"UMI", "Ursa Minor"}, {"VEL", "Vela"}, {"VIR", "Virgo"}, {"VOL", "Volans"},
+    {"VUL", "Vulpecula"}
+};
+
+//! Alternative names used for constellations in the source data files, which map onto the names above
+static const char *constellation_aliases[][2] = {
+    {"Boötes", "BOO"}, {"SerpensA", "SER"}, {"SerpensB", "SER"}, {"Serpens Caput", "SER"}, {"Serpens Cauda", "SER"},
+    {NULL, NULL}
+};
+
+//! constellation_id_from_abbreviation - Look up the numeric id of a constellation from its three-letter
+//! abbreviation. The two halves of Serpens, SER1 and SER2, both map onto Serpens.
+//! \param abbreviation - The abbreviation of the constellation, e.g. "ORI", in any case
+//! \return - The numeric id of the constellation, or -1 if it is not recognised
+
+int constellation_id_from_abbreviation(const char *abbreviation) {
+    char buffer[4];
+    int length = 0;
+    while ((length < 3) && (abbreviation[length] != '\0')) {
+        buffer[length] = (char) toupper((unsigned char) abbreviation[length]);
+        length++;
+    }
+    buffer[length] = '\0';
+    if ((length != 3) || ((abbreviation[3] != '\0') && (strcmp(abbreviation + 3, "1") != 0) &&
+                          (strcmp(abbreviation + 3, "2") != 0))) {
+        return -1;
+    }
+
+    for (int i = 0; i < CONSTELLATION_COUNT; i++) {
+        if (strcmp(buffer, constellation_table[i][0]) == 0) return i;
+    }
+    return -1;
+}
+
+//! constellation_names_match - Compare two constellation names, ignoring case and any spaces or @ characters, so
+//! that "Canes Venatici", "Canes@Venatici" and "CanesVenatici" are all equivalent
+//! \param a - The first name
+//! \param b - The second name
+//! \return - Boolean flag indicating whether the names match
+
+static int constellation_names_match(const char *a, const char *b) {
+    while (1) {
+        while ((*a == ' ') || (*a == '@')) a++;
+        while ((*b == ' ') || (*b == '@')) b++;
+        if (tolower((unsigned char) *a) != tolower((unsigned char) *b)) return 0;
+        if (*a == '\0') return 1;
+        a++;
+        b++;
+    }
+}
+
+//! constellation_id_from_name - Look up the numeric id of a constellation from its English name
+//! \param name - The name of the constellation, e.g. "Ursa Major", "Ursa@Major" or "UrsaMajor"
+//! \return - The numeric id of the constellation, or -1 if it is not recognised
+
+int constellation_id_from_name(const char *name) {
+    for (int i = 0; i < CONSTELLATION_COUNT; i++) {
+        if (constellation_names_match(name, constellation_table[i][1])) return i;
+    }
+    for (int i = 0; constellation_aliases[i][0] != NULL; i++) {
+        if (constellation_names_match(name, constellation_aliases[i][0])) {
+            return constellation_id_from_abbreviation(constellation_aliases[i][1]);
+        }
+    }
+    return -1;
+}
+
+//! constellation_abbreviation - Return the three-letter abbreviation of a constellation
+//! \param constellation_id - The numeric id of the constellation
+//! \return - The abbreviation of the constellation, or NULL if the id is not valid
+
+const char *constellation_abbreviation(int constellation_id) {
+    if ((constellation_id < 0) || (constellation_id >= CONSTELLATION_COUNT)) return NULL;
+    return constellation_table[constellation_id][0];
+}
+
+//! constellation_name - Return the English name of a constellation
+//! \param constellation_id - The numeric id of the constellation
+//! \return - The name of the constellation, or NULL if the id is not valid
+
+const char *constellation_name(int constellation_id) {
+    if ((constellation_id < 0) || (constellation_id >= CONSTELLATION_COUNT)) return NULL;
+    return constellation_table[constellation_id][1];
+}
+
+//! constellation_mask_from_list - Convert a comma-separated list of constellation abbreviations, e.g. "ORI,TAU",
+//! into a bit mask indexed by constellation id
+//! \param list - The comma-separated list of abbreviations
+//! \param [out] mask - The bit mask to populate, of length CONSTELLATION_MASK_WORDS
+//! \return - Zero on success, or one if the list contained an abbreviation we did not recognise
+
+int constellation_mask_from_list(const char *list, uint64_t *mask) {
+    memset(mask, 0, CONSTELLATION_MASK_WORDS * sizeof(uint64_t));
+
+    while (*list != '\0') {
+        char abbreviation[8];
+        int length = 0;
+        while ((*list == ',') || (*list == ' ')) list++;
+        if (*list == '\0') break;
+        while ((*list != '\0') && (*list != ',') && (*list != ' ')) {
+            if (length < (int) sizeof(abbreviation) - 1) abbreviation[length++] = *list;
+            list++;
+        }
+        abbreviation[length] = '\0';
+
+        const int constellation_id = constellation_id_from_abbreviation(abbreviation);
+        if (constellation_id < 0) return 1;
+        CONSTELLATION_MASK_SET(mask, constellation_id);
+    }
+    return 0;
+}
+
+//! geometry_builder - Accumulates pieces of constellation geometry while compiling the binary file
+typedef struct {
+    constellation_geometry_info *groups;
+    int group_count, group_capacity;
+    constellation_vertex *vertices;
+    int vertex_count, vertex_capacity;
+} geometry_builder;
+
+//! builder_begin_group - Start a new piece of constellation geometry
+//! \param b - The geometry builder
+//! \param name - The name of the constellation
+//! \param kind - The kind of geometry, e.g. CONSTELLATION_BOUNDARIES
+//! \param constellation_id - The numeric id of the constellation
+
+static void builder_begin_group(geometry_builder *b, const char *name, int kind, int constellation_id) {
+    if ((constellation_id < 0) || (constellation_id >= CONSTELLATION_COUNT)) {
+        snprintf(temp_err_string, FNAME_LENGTH, "Unrecognised constellation <%s> in constellation data.", name);
+        stch_fatal(__FILE__, __LINE__, temp_err_string);
+    }
+
+    if (b->group_count >= b->group_capacity) {
+        b->group_capacity = 2 * b->group_capacity + 64;
+        b->groups = realloc(b->groups, b->group_capacity * sizeof(constellation_geometry_info));
+        if (b->groups == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+    constellation_geometry_info *group = &b->groups[b->group_count++];
+    memset((void *) group, 0, sizeof(constellation_geometry_info)); // Ensures md5 checksum is the same on each run
+    snprintf(group->name, sizeof(group->name), "%s", name);
+    group->kind = kind;
+    group->constellation_id = constellation_id;
+    group->file_position = b->vertex_count;
+}
+
+//! builder_add_vertex - Add a vertex to the piece of constellation geometry we are building
+//! \param b - The geometry builder
+//! \param ra - The right ascension of the vertex (radians)
+//! \param dec - The declination of the vertex (radians)
+//! \param flags - Bitwise OR of CONSTELLATION_VERTEX_* flags
+
+static void builder_add_vertex(geometry_builder *b, double ra, double dec, int flags) {
+    if (b->vertex_count >= b->vertex_capacity) {
+        b->vertex_capacity = 2 * b->vertex_capacity + 4096;
+        b->vertices = realloc(b->vertices, b->vertex_capacity * sizeof(constellation_vertex));
+        if (b->vertices == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+    constellation_vertex *v = &b->vertices[b->vertex_count++];
+    memset((void *) v, 0, sizeof(constellation_vertex));
+    v->ra = ra;
+    v->dec = dec;
+    v->xyz[0] = cos(dec) * cos(ra);
+    v->xyz[1] = cos(dec) * sin(ra);
+    v->xyz[2] = sin(dec);
+    v->flags = flags;
+    b->groups[b->group_count - 1].vertex_count++;
+}
+
+//! builder_end_group - Finish the piece of constellation geometry we are building, and compute its bounding cap
+//! \param b - The geometry builder
+
+static void builder_end_group(geometry_builder *b) {
+    if (b->group_count == 0) return;
+    constellation_geometry_info *group = &b->groups[b->group_count - 1];
+    const constellation_vertex *vertices = b->vertices + group->file_position;
+
+    // Discard empty groups
+    if (group->vertex_count == 0) {
+        b->group_count--;
+        return;
+    }
+
+    // The cap is centred on the mean direction of the vertices
+    double norm = 0;
+    for (int i = 0; i < group->vertex_count; i++)
+        for (int j = 0; j < 3; j++) group->centre[j] += vertices[i].xyz[j];
+    for (int j = 0; j < 3; j++) norm += gsl_pow_2(group->centre[j]);
+    norm = sqrt(norm);
+    for (int j = 0; j < 3; j++) group->centre[j] = (norm > 0) ? group->centre[j] / norm : 0;
+
+    // ... and its radius is the distance to the furthest vertex
+    group->radius = (norm > 0) ? 0 : M_PI;
+    for (int i = 0; i < group->vertex_count; i++) {
+        const double cos_distance = (group->centre[0] * vertices[i].xyz[0] + group->centre[1] * vertices[i].xyz[1] +
+                                     group->centre[2] * vertices[i].xyz[2]);
+        group->radius = gsl_max(group->radius, acos(gsl_max(-1, gsl_min(1, cos_distance))));
+    }
+}
+
+//! compile_boundaries - Read the boundaries of the constellations from <boundaries.dat>
+//! \param b - The geometry builder
+
+static void compile_boundaries(geometry_builder *b) {
+    char line[FNAME_LENGTH], constellation[6] = "@@@@";
+
+    FILE *file = fopen(SRCDIR "../data/constellations/downloads/boundaries.dat", "r");
+    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation boundary data");
+
+    while ((!feof(file)) && (!ferror(file))) {
+        double ra, dec;
+        const char *scan;
+        file_readline(file, line);
+        if ((line[0] == '#') || (strlen(line) < 28)) continue; // Comment line
+        scan = line + 0;
+        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
+        ra = get_float(scan, NULL);
+        scan = line + 12;
+        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
+        dec = get_float(scan, NULL);
+        if (line[11] == '-') dec = -dec;
+
+        // Each run of points with the same constellation abbreviation is a separate closed boundary
+        if (strncmp(line + 23, constellation, 4) != 0) {
+            if (constellation[0] != '@') {
+                // Close the previous boundary by returning to its first point
+                const constellation_geometry_info *group = &b->groups[b->group_count - 1];
+                if (group->vertex_count > 0) {
+                    const constellation_vertex first = b->vertices[group->file_position];
+                    builder_add_vertex(b, first.ra, first.dec, 0);
+                }
+                builder_end_group(b);
+            }
+            strncpy(constellation, line + 23, 4);
+            constellation[4] = '\0';
+
+            char name[6];
+            get_word(name, constellation, sizeof(name));
+            builder_begin_group(b, name, CONSTELLATION_BOUNDARIES, constellation_id_from_abbreviation(name));
+        }
+
+        // Boundaries are stored as complete closed polygons, so that they can also be used to look up which
+        // constellation a point lies in
+        const int first_vertex = (b->groups[b->group_count - 1].vertex_count == 0);
+        builder_add_vertex(b, ra * M_PI / 12, dec * M_PI / 180, first_vertex ? CONSTELLATION_VERTEX_PEN_UP : 0);
+    }
+    builder_end_group(b);
+    fclose(file);
+}
+
+//! compile_sticks - Read the stick figures of the constellations from one of the <*_by_RA_Dec.dat> files
+//! \param b - The geometry builder
+//! \param filename - The name of the file listing the stick figures
+//! \param kind - The kind of geometry these stick figures are stored as
+
+static void compile_sticks(geometry_builder *b, const char *filename, int kind) {
+    char line[FNAME_LENGTH], path[FNAME_LENGTH], constellation[32] = "";
+
+    snprintf(path, FNAME_LENGTH, "%s%s%s", SRCDIR, "../data/constellations/process_stick_figures/output/", filename);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation stick figures");
+
+    while ((!feof(file)) && (!ferror(file))) {
+        double ra0, dec0, ra1, dec1;
+        file_readline(file, line);
+        if (line[0] == '#') continue; // Comment line
+        const char *scan = line;
+        while ((scan[0] != '\0') && (scan[0] <= ' ')) scan++;
+        const char *name = scan;
+        while ((scan[0] != '\0') && (scan[0] != '-') && (scan[0] != '.') && (scan[0] != '+') &&
+               ((scan[0] < '0') || (scan[0] > '9')))
+            scan++;
+        if (scan[0] == '\0') continue; // Blank line
+
+        // The name of the constellation is the text before the first number, without trailing spaces
+        int name_length = (int) gsl_min(scan - name, sizeof(constellation) - 1);
+        while ((name_length > 0) && (name[name_length - 1] <= ' ')) name_length--;
+
+        // Each run of sticks with the same constellation name is stored together
+        if ((b->group_count == 0) || (b->groups[b->group_count - 1].kind != kind) ||
+            (strlen(constellation) != name_length) || (strncmp(constellation, name, name_length) != 0)) {
+            builder_end_group(b);
+            memcpy(constellation, name, name_length);
+            constellation[name_length] = '\0';
+            builder_begin_group(b, constellation, kind, constellation_id_from_name(constellation));
+        }
+
+        ra0 = get_float(scan, NULL);
+        scan = next_word(scan);
+        dec0 = get_float(scan, NULL);
+        scan = next_word(scan);
+        ra1 = get_float(scan, NULL);
+        scan = next_word(scan);
+        dec1 = get_float(scan, NULL);
+        builder_add_vertex(b, ra0 * M_PI / 180, dec0 * M_PI / 180, CONSTELLATION_VERTEX_PEN_UP);
+        builder_add_vertex(b, ra1 * M_PI / 180, dec1 * M_PI / 180, 0);
+    }
+    builder_end_group(b);
+    fclose(file);
+}
+
+//! compile_names - Read the candidate positions for the names of the constellations from <name_places.dat>
+//! \param b - The geometry builder
+//! \param filename - The name of the file listing the name positions
+//! \param kind - The kind of geometry these name positions are stored as
+//! \param translation_of - For files of translated names, which cannot be looked up by name, the kind of geometry
+//! holding the English names, which are listed in the same order. Otherwise -1.
+
+static void compile_names(geometry_builder *b, const char *filename, int kind, int translation_of) {
+    char line[FNAME_LENGTH], path[FNAME_LENGTH];
+    int english_index = 0;
+
+    snprintf(path, FNAME_LENGTH, "%s%s%s", SRCDIR, "../data/constellations/", filename);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation name data");
+
+    while ((!feof(file)) && (!ferror(file))) {
+        file_readline(file, line);
+        if (line[0] == '#') continue; // Comment line
+        const char *scan = line;
+        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
+        if (scan[0] == '\0') continue; // Blank line
+
+        // Each line lists a constellation's name, followed by candidate positions in order of preference
+        char name[32];
+        get_word(name, scan, sizeof(name));
+        scan = next_word(scan);
+
+        // Work out which constellation this line refers to
+        int constellation_id = -1;
+        if (translation_of < 0) {
+            constellation_id = constellation_id_from_name(name);
+        } else {
+            while ((english_index < b->group_count) && (b->groups[english_index].kind != translation_of))
+                english_index++;
+            if (english_index < b->group_count) constellation_id = b->groups[english_index++].constellation_id;
+        }
+        builder_begin_group(b, name, kind, constellation_id);
+
+        while (scan[0] != '\0') {
+            const double ra = get_float(scan, NULL);
+            scan = next_word(scan);
+            const double dec = get_float(scan, NULL);
+            scan = next_word(scan);
+            builder_add_vertex(b, ra * M_PI / 12, dec * M_PI / 180, 0);
+        }
+        builder_end_group(b);
+    }
+    fclose(file);
+}
+
+//! constellation_geometry_to_binary - Compile the boundaries, stick figures and name positions of the
+//! constellations into <constellation_geometry.bin>. This means we can read them much faster next time.
+
+void constellation_geometry_to_binary() {
+    geometry_builder b = {NULL, 0, 0, NULL, 0, 0};
+
+    compile_boundaries(&b);
+    compile_sticks(&b, "constellation_lines_simplified_by_RA_Dec.dat", CONSTELLATION_STICKS_SIMPLIFIED);
+    compile_sticks(&b, "constellation_lines_rey_by_RA_Dec.dat", CONSTELLATION_STICKS_REY);
+    compile_names(&b, "name_places.dat", CONSTELLATION_NAMES_EN, -1);
+    compile_names(&b, "name_places_fr.dat", CONSTELLATION_NAMES_FR, CONSTELLATION_NAMES_EN);
+
+    constellation_geometry geometry;
+    geometry.binary_version = constellation_geometry_binary_format_version;
+    geometry.group_count = b.group_count;
+    geometry.file_vertices_start_position = 0;
+    geometry.groups = b.groups;
+
+    // Start writing binary output file
+    FILE *out = fopen(binary_constellation_geometry, "wb");
+    if (out == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary constellation geometry for output");
+
+    // Write the header, followed by all the vertices
+    fwrite(&geometry.binary_version, sizeof(int), 1, out);
+    fwrite(&geometry.group_count, sizeof(int), 1, out);
+    geometry.file_vertices_start_position = (ftell(out) + sizeof(unsigned long int) +
+                                             geometry.group_count * sizeof(constellation_geometry_info));
+    fwrite(&geometry.file_vertices_start_position, sizeof(unsigned long int), 1, out);
+    fwrite(geometry.groups, geometry.group_count * sizeof(constellation_geometry_info), 1, out);
+    fwrite(b.vertices, b.vertex_count * sizeof(constellation_vertex), 1, out);
+    fclose(out);
+
+    // Free up the temporary arrays we used
+    free(b.groups);
+    free(b.vertices);
+}
+
+//! open_constellation_geometry - Open the binary file of constellation geometry (for reading), compiling it from
+//! the text files if it does not exist
+//! \return - File handle
+
+FILE *open_constellation_geometry() {
+    FILE *file = fopen(binary_constellation_geometry, "r");
+
+    // If binary file was opened, check the version number is correct
+    if (file != NULL) {
+        int version_number;
+        if ((fread(&version_number, sizeof(int), 1, file) != 1) ||
+            (version_number != constellation_geometry_binary_format_version)) {
+            fclose(file);
+            file = NULL;
+        }
+    }
+
+    // If binary file did not open successfully, recreate it from the text files
+    if (file == NULL) {
+        constellation_geometry_to_binary();
+        file = fopen(binary_constellation_geometry, "r");
+        if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary constellation geometry for reading");
+    }
+
+    // Return to the beginning of the file
+    fseek(file, 0, SEEK_SET);
+    return file;
+}
+
+//! read_constellation_geometry_headers - Read the header of the binary constellation geometry file
+//! \param file - File handle to read the header from
+//! \return - A <constellation_geometry> structure
+
+constellation_geometry read_constellation_geometry_headers(FILE *file) {
+    fseek(file, 0, SEEK_SET);
+
+    constellation_geometry geometry;
+    fread(&geometry.binary_version, sizeof(int), 1, file);
+    fread(&geometry.group_count, sizeof(int), 1, file);
+    fread(&geometry.file_vertices_start_position, sizeof(unsigned long int), 1, file);
+
+    geometry.groups = malloc(gsl_max(1, geometry.group_count) * sizeof(constellation_geometry_info));
+    if (geometry.groups == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    fread(geometry.groups, geometry.group_count * sizeof(constellation_geometry_info), 1, file);
+    return geometry;
+}
+
+//! free_constellation_geometry_headers - Free up the storage used by a <constellation_geometry> structure
+//! \param geometry - A <constellation_geometry> structure to free
+
+void free_constellation_geometry_headers(constellation_geometry *geometry) {
+    if (geometry->groups != NULL) {
+        free(geometry->groups);
+        geometry->groups = NULL;
+    }
+}
+
+//! constellation_field_radius - Work out the cap on the sky, centred on the centre of the chart, against which we
+//! test whether constellation geometry is visible
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param [out] centre - Unit vector pointing at the centre of the chart
+//! \return - The angular radius of the cap (radians), or pi if everything is potentially visible
+
+static double constellation_field_radius(chart_config *s, double *centre) {
+    centre[0] = cos(s->dec0) * cos(s->ra0);
+    centre[1] = cos(s->dec0) * sin(s->ra0);
+    centre[2] = sin(s->dec0);
+
+    // Constellation geometry is stored in RA/Dec, so we can only compare it against the field of view if the chart
+    // is centred in the same coordinates
+    if (s->coords == SW_COORDS_GAL) return M_PI;
+    return gsl_min(M_PI, CONSTELLATION_FIELD_MARGIN * field_of_view_radius(s));
+}
+
+//! constellation_in_field_of_view - Test whether a piece of constellation geometry may be visible on a chart
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param group - The piece of constellation geometry
+//! \return - Boolean flag indicating whether the geometry's bounding cap intersects the field of view
+
+int constellation_in_field_of_view(chart_config *s, const constellation_geometry_info *group) {
+    double centre[3];
+    const double field_radius = constellation_field_radius(s, centre);
+    if (field_radius >= M_PI) return 1;
+
+    // Straight lines between vertices are only guaranteed to stay within caps smaller than a hemisphere
+    if (group->radius >= M_PI / 2) return 1;
+
+    const double cos_distance = (group->centre[0] * centre[0] + group->centre[1] * centre[1] +
+                                 group->centre[2] * centre[2]);
+    return acos(gsl_max(-1, gsl_min(1, cos_distance))) <= field_radius + group->radius;
+}
+
+//! constellation_vertex_in_field_of_view - Test whether a single constellation vertex may be visible on a chart
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param vertex - The vertex to test
+//! \return - Boolean flag indicating whether the vertex lies within the field of view
+
+int constellation_vertex_in_field_of_view(chart_config *s, const constellation_vertex *vertex) {
+    double centre[3];
+    const double field_radius = constellation_field_radius(s, centre);
+    if (field_radius >= M_PI) return 1;
+
+    const double cos_distance = (vertex->xyz[0] * centre[0] + vertex->xyz[1] * centre[1] + vertex->xyz[2] * centre[2]);
+    return cos_distance >= cos(field_radius);
+}
+
+//! read_constellation_vertices - Read the vertices of a piece of constellation geometry into a buffer, which is
+//! grown as required
+//! \param file - File handle for the binary constellation geometry
+//! \param geometry - The header information read from the binary file
+//! \param group - The piece of geometry whose vertices we should read
+//! \param buffer - Pointer to the buffer to read the vertices into, which may be NULL initially
+//! \param buffer_capacity - Pointer to the number of vertices the buffer has space for
+//! \return - Pointer to the vertices
+
+constellation_vertex *read_constellation_vertices(FILE *file, const constellation_geometry *geometry,
+                                                  const constellation_geometry_info *group,
+                                                  constellation_vertex **buffer, int *buffer_capacity) {
+    if ((*buffer == NULL) || (group->vertex_count > *buffer_capacity)) {
+        *buffer_capacity = (int) gsl_max(1024, gsl_max(group->vertex_count, 2. * *buffer_capacity));
+        *buffer = realloc(*buffer, *buffer_capacity * sizeof(constellation_vertex));
+        if (*buffer == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+
+    fseek(file, (long) (geometry->file_vertices_start_position + group->file_position * sizeof(constellation_vertex)),
+          SEEK_SET);
+    if (fread(*buffer, sizeof(constellation_vertex), group->vertex_count, file) != group->vertex_count) {
+        stch_fatal(__FILE__, __LINE__, "Could not read constellation geometry");
+    }
+    return *buffer;
+}
@@ -0,0 +1,101 @@
+// constellationGeometry.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef CONSTELLATION_GEOMETRY_H
+#define CONSTELLATION_GEOMETRY_H 1
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "settings/chart_config.h"
+
+//! The kinds of geometry stored for each constellation
+#define CONSTELLATION_BOUNDARIES 0
+#define CONSTELLATION_STICKS_SIMPLIFIED 1
+#define CONSTELLATION_STICKS_REY 2
+#define CONSTELLATION_NAMES_EN 3
+#define CONSTELLATION_NAMES_FR 4
+
+//! Flag set on vertices where the pen should be lifted before moving to the vertex
+#define CONSTELLATION_VERTEX_PEN_UP 1
+
+//! The number of constellations recognised by the IAU. Each is given a numeric id in the range 0 to 87.
+#define CONSTELLATION_COUNT 88
+
+//! constellation_vertex - A single vertex of a constellation's boundary or stick figure, or a candidate position
+//! for its name
+typedef struct {
+    double ra, dec; // radians, J2000.0
+    double xyz[3]; // Unit vector pointing at this vertex, in J2000 equatorial coordinates
+    int flags; // Bitwise OR of CONSTELLATION_VERTEX_* flags
+} constellation_vertex;
+
+//! constellation_geometry_info - Information about a single piece of constellation geometry, and where its vertices
+//! are to be found in the binary geometry file
+typedef struct {
+    char name[32]; // The name of the constellation, as given in the source file
+    int kind; // One of the CONSTELLATION_BOUNDARIES ... CONSTELLATION_NAMES_FR constants
+    int constellation_id; // The numeric id of the constellation, 0 to CONSTELLATION_COUNT-1
+    double centre[3]; // Unit vector pointing at the centre of the cap which encloses every vertex
+    double radius; // Angular radius of the bounding cap (radians)
+    int vertex_count; // The number of vertices
+
+    // The location in the binary file where the vertices start
+    // Stored in units of sizeof(constellation_vertex) beyond the start point of <file_vertices_start_position> bytes
+    int file_position;
+} constellation_geometry_info;
+
+//! constellation_geometry - Information stored in the header of the binary constellation geometry file
+typedef struct {
+    int binary_version; // The version number of the code which produced this binary file
+    int group_count; // The number of pieces of geometry in the file
+    unsigned long int file_vertices_start_position; // The position within file where the vertices start
+    constellation_geometry_info *groups; // Information about every piece of geometry
+} constellation_geometry;
+
+int constellation_id_from_abbreviation(const char *abbreviation);
+
+int constellation_id_from_name(const char *name);
+
+const char *constellation_abbreviation(int constellation_id);
+
+const char *constellation_name(int constellation_id);
+
+int constellation_mask_from_list(const char *list, uint64_t *mask);
+
+FILE *open_constellation_geometry();
+
+constellation_geometry read_constellation_geometry_headers(FILE *file);
+
+void free_constellation_geometry_headers(constellation_geometry *geometry);
+
+int constellation_in_field_of_view(chart_config *s, const constellation_geometry_info *group);
+
+int constellation_vertex_in_field_of_view(chart_config *s, const constellation_vertex *vertex);
+
+constellation_vertex *read_constellation_vertices(FILE *file, const constellation_geometry *geometry,
+                                                  const constellation_geometry_info *group,
+                                                  constellation_vertex **buffer, int *buffer_capacity);
+
+void constellation_geometry_to_binary();
+
+#endif
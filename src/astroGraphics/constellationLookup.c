@@ -0,0 +1,321 @@
+// constellationLookup.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// Look up which constellation any point on the sky lies within, using the constellation boundaries stored in the
+// binary constellation geometry file.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+
+#include "astroGraphics/constellationGeometry.h"
+#include "astroGraphics/constellationLookup.h"
+#include "coreUtils/errorReport.h"
+
+//! cell_pair - Records that an edge of a constellation polygon passes through a cell of the lookup index
+typedef struct {
+    int cell, polygon;
+} cell_pair;
+
+//! wrap_angle - Wrap an angle into the range -pi to pi
+//! \param x - The angle to wrap (radians)
+//! \return - The wrapped angle (radians)
+
+static inline double wrap_angle(double x) {
+    while (x > M_PI) x -= 2 * M_PI;
+    while (x <= -M_PI) x += 2 * M_PI;
+    return x;
+}
+
+//! point_in_polygon - Test whether a point lies inside a constellation polygon. We count how many edges of the
+//! polygon are crossed by the meridian running north from the point to the celestial pole. An odd number of crossings
+//! means the point lies on the opposite side of the boundary from the pole.
+//! \param polygon - The polygon to test
+//! \param ra - The right ascension of the point (radians)
+//! \param dec - The declination of the point (radians)
+//! \return - Boolean flag indicating whether the point lies inside the polygon
+
+static int point_in_polygon(const constellation_polygon *polygon, double ra, double dec) {
+    // Quick rejection of points outside the range of declinations the polygon spans
+    if ((dec > polygon->dec_max) && (polygon->contains_pole <= 0)) return 0;
+    if ((dec < polygon->dec_min) && (polygon->contains_pole >= 0)) return 0;
+
+    int inside = (polygon->contains_pole > 0);
+    for (int i = 0; i < polygon->vertex_count - 1; i++) {
+        // Work in RA offsets from the first vertex of each edge, so that edges crossing RA=0 need no special care
+        const double ra_edge = wrap_angle(polygon->ra[i + 1] - polygon->ra[i]);
+        const double ra_point = wrap_angle(ra - polygon->ra[i]);
+        if ((0 > ra_point) == (ra_edge > ra_point)) continue;
+
+        const double dec_crossing = polygon->dec[i] + (polygon->dec[i + 1] - polygon->dec[i]) * ra_point / ra_edge;
+        if (dec_crossing > dec) inside = !inside;
+    }
+    return inside;
+}
+
+//! lookup_exhaustive - Find which constellation a point lies in by testing every polygon in turn
+//! \param index - The constellation lookup index
+//! \param ra - The right ascension of the point (radians)
+//! \param dec - The declination of the point (radians)
+//! \return - The numeric id of the constellation, or -1 if the point did not fall inside any polygon
+
+static int lookup_exhaustive(const constellation_lookup *index, double ra, double dec) {
+    for (int i = 0; i < index->polygon_count; i++) {
+        if (point_in_polygon(&index->polygons[i], ra, dec)) return index->polygons[i].constellation_id;
+    }
+    return -1;
+}
+
+//! lookup_candidates - Find which constellation a point lies in by testing a list of candidate polygons
+//! \param index - The constellation lookup index
+//! \param candidates - The number of candidate polygons, followed by their indices
+//! \param ra - The right ascension of the point (radians)
+//! \param dec - The declination of the point (radians)
+//! \return - The numeric id of the constellation, or -1 if the point did not fall inside any candidate
+
+static int lookup_candidates(const constellation_lookup *index, const int *candidates, double ra, double dec) {
+    for (int i = 1; i <= candidates[0]; i++) {
+        const constellation_polygon *polygon = &index->polygons[candidates[i]];
+        if (point_in_polygon(polygon, ra, dec)) return polygon->constellation_id;
+    }
+    return -1;
+}
+
+//! compare_cell_pairs - Sort cell_pair structures by cell, and then by polygon
+//! \param a - The first pair
+//! \param b - The second pair
+//! \return - Comparison result for qsort
+
+static int compare_cell_pairs(const void *a, const void *b) {
+    const cell_pair *x = (const cell_pair *) a;
+    const cell_pair *y = (const cell_pair *) b;
+    if (x->cell != y->cell) return (x->cell < y->cell) ? -1 : 1;
+    if (x->polygon != y->polygon) return (x->polygon < y->polygon) ? -1 : 1;
+    return 0;
+}
+
+//! read_polygons - Read the constellation boundaries from the binary constellation geometry file
+//! \param index - The constellation lookup index to populate with polygons
+
+static void read_polygons(constellation_lookup *index) {
+    FILE *file = open_constellation_geometry();
+    constellation_geometry geometry = read_constellation_geometry_headers(file);
+    constellation_vertex *vertices = NULL;
+    int vertex_capacity = 0;
+
+    index->polygon_count = 0;
+    index->polygons = malloc(gsl_max(1, geometry.group_count) * sizeof(constellation_polygon));
+    if (index->polygons == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+    for (int i = 0; i < geometry.group_count; i++) {
+        const constellation_geometry_info *group = &geometry.groups[i];
+        if ((group->kind != CONSTELLATION_BOUNDARIES) || (group->vertex_count < 2)) continue;
+        read_constellation_vertices(file, &geometry, group, &vertices, &vertex_capacity);
+
+        constellation_polygon *polygon = &index->polygons[index->polygon_count++];
+        polygon->constellation_id = group->constellation_id;
+        polygon->vertex_count = group->vertex_count;
+        polygon->ra = malloc(2 * group->vertex_count * sizeof(double));
+        if (polygon->ra == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+        polygon->dec = polygon->ra + group->vertex_count;
+
+        // The boundaries are stored closed, with the first vertex repeated at the end
+        double winding = 0, dec_sum = 0;
+        polygon->dec_min = M_PI / 2;
+        polygon->dec_max = -M_PI / 2;
+        for (int j = 0; j < group->vertex_count; j++) {
+            polygon->ra[j] = vertices[j].ra;
+            polygon->dec[j] = vertices[j].dec;
+            polygon->dec_min = gsl_min(polygon->dec_min, vertices[j].dec);
+            polygon->dec_max = gsl_max(polygon->dec_max, vertices[j].dec);
+            dec_sum += vertices[j].dec;
+            if (j > 0) winding += wrap_angle(vertices[j].ra - vertices[j - 1].ra);
+        }
+
+        // A polygon whose edges wind all the way around in RA encloses one of the celestial poles
+        polygon->contains_pole = 0;
+        if (fabs(winding) > M_PI) polygon->contains_pole = (dec_sum > 0) ? 1 : -1;
+    }
+
+    free(vertices);
+    free_constellation_geometry_headers(&geometry);
+    fclose(file);
+}
+
+//! add_cell_pair - Record that an edge of a polygon passes through a cell of the lookup index
+//! \param pairs - The buffer of pairs, which is grown as required
+//! \param pair_count - The number of pairs in the buffer
+//! \param pair_capacity - The number of pairs the buffer has space for
+//! \param cell - The cell number
+//! \param polygon - The polygon number
+
+static void add_cell_pair(cell_pair **pairs, int *pair_count, int *pair_capacity, int cell, int polygon) {
+    if (*pair_count >= *pair_capacity) {
+        *pair_capacity = 2 * *pair_capacity + 65536;
+        *pairs = realloc(*pairs, *pair_capacity * sizeof(cell_pair));
+        if (*pairs == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+    (*pairs)[*pair_count].cell = cell;
+    (*pairs)[*pair_count].polygon = polygon;
+    (*pair_count)++;
+}
+
+//! constellation_lookup_open - Build an index used to look up which constellation any point on the sky lies within
+//! \return - A newly allocated <constellation_lookup> structure, to be freed with constellation_lookup_close
+
+constellation_lookup *constellation_lookup_open() {
+    const double ra_cell_size = 2 * M_PI / CONSTELLATION_LOOKUP_RA_CELLS;
+    const double dec_cell_size = M_PI / CONSTELLATION_LOOKUP_DEC_CELLS;
+    const int cell_count = CONSTELLATION_LOOKUP_RA_CELLS * CONSTELLATION_LOOKUP_DEC_CELLS;
+
+    constellation_lookup *index = malloc(sizeof(constellation_lookup));
+    if (index == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    read_polygons(index);
+
+    // Find every cell crossed by each polygon edge. Each edge is a straight line in RA/Dec, so it lies within the
+    // rectangle of cells spanned by its end points.
+    cell_pair *pairs = NULL;
+    int pair_count = 0, pair_capacity = 0;
+    for (int i = 0; i < index->polygon_count; i++) {
+        const constellation_polygon *polygon = &index->polygons[i];
+        for (int j = 0; j < polygon->vertex_count - 1; j++) {
+            const double ra_start = polygon->ra[j];
+            const double ra_end = ra_start + wrap_angle(polygon->ra[j + 1] - ra_start);
+            const int col_min = (int) floor(gsl_min(ra_start, ra_end) / ra_cell_size);
+            const int col_max = (int) floor(gsl_max(ra_start, ra_end) / ra_cell_size);
+            const int row_min = (int) gsl_max(0, floor((gsl_min(polygon->dec[j], polygon->dec[j + 1]) + M_PI / 2) /
+                                                       dec_cell_size));
+            const int row_max = (int) gsl_min(CONSTELLATION_LOOKUP_DEC_CELLS - 1,
+                                              floor((gsl_max(polygon->dec[j], polygon->dec[j + 1]) + M_PI / 2) /
+                                                    dec_cell_size));
+            for (int col = col_min; col <= col_max; col++) {
+                const int col_wrapped = ((col % CONSTELLATION_LOOKUP_RA_CELLS) + CONSTELLATION_LOOKUP_RA_CELLS) %
+                                        CONSTELLATION_LOOKUP_RA_CELLS;
+                for (int row = row_min; row <= row_max; row++) {
+                    add_cell_pair(&pairs, &pair_count, &pair_capacity,
+                                  row * CONSTELLATION_LOOKUP_RA_CELLS + col_wrapped, i);
+                }
+            }
+        }
+    }
+    qsort(pairs, pair_count, sizeof(cell_pair), compare_cell_pairs);
+
+    // Cells crossed by boundaries store a list of the polygons which cross them
+    index->cells = malloc(cell_count * sizeof(int));
+    index->candidates = malloc((2 * pair_count + 1) * sizeof(int));
+    if ((index->cells == NULL) || (index->candidates == NULL)) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    for (int i = 0; i < cell_count; i++) index->cells[i] = CONSTELLATION_COUNT;
+
+    int candidate_count = 0;
+    for (int i = 0; i < pair_count; i++) {
+        const int cell = pairs[i].cell;
+        if ((i > 0) && (pairs[i - 1].cell == cell)) {
+            if (pairs[i - 1].polygon != pairs[i].polygon) {
+                index->candidates[-1 - index->cells[cell]]++;
+                index->candidates[candidate_count++] = pairs[i].polygon;
+            }
+            continue;
+        }
+        index->cells[cell] = -1 - candidate_count;
+        index->candidates[candidate_count++] = 1;
+        index->candidates[candidate_count++] = pairs[i].polygon;
+    }
+    free(pairs);
+
+    // Cells not crossed by any boundary lie entirely within a single constellation. Work down each column of cells
+    // from the north pole; a cell lies in the same constellation as the cell above it, unless that was crossed by a
+    // boundary, in which case we test its candidate polygons.
+    for (int col = 0; col < CONSTELLATION_LOOKUP_RA_CELLS; col++) {
+        int previous = -1;
+        for (int row = CONSTELLATION_LOOKUP_DEC_CELLS - 1; row >= 0; row--) {
+            const int cell = row * CONSTELLATION_LOOKUP_RA_CELLS + col;
+            if (index->cells[cell] < 0) {
+                previous = cell;
+                continue;
+            }
+
+            int constellation_id = -1;
+            if ((previous >= 0) && (index->cells[previous] >= 0)) {
+                constellation_id = index->cells[previous];
+            } else {
+                const double ra = (col + 0.5) * ra_cell_size;
+                const double dec = (row + 0.5) * dec_cell_size - M_PI / 2;
+                if (previous >= 0) {
+                    constellation_id = lookup_candidates(index, index->candidates + (-1 - index->cells[previous]),
+                                                         ra, dec);
+                }
+                if (constellation_id < 0) constellation_id = lookup_exhaustive(index, ra, dec);
+            }
+
+            // If the cell centre fell through a gap between polygons, fall back to testing every polygon on demand
+            if (constellation_id < 0) {
+                index->cells[cell] = -1 - candidate_count;
+                index->candidates = realloc(index->candidates, (candidate_count + 1) * sizeof(int));
+                if (index->candidates == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+                index->candidates[candidate_count++] = 0;
+            } else {
+                index->cells[cell] = constellation_id;
+            }
+            previous = cell;
+        }
+    }
+    return index;
+}
+
+//! constellation_lookup_close - Free up the storage used by a constellation lookup index
+//! \param index - The index to free
+
+void constellation_lookup_close(constellation_lookup *index) {
+    if (index == NULL) return;
+    for (int i = 0; i < index->polygon_count; i++) free(index->polygons[i].ra);
+    free(index->polygons);
+    free(index->cells);
+    free(index->candidates);
+    free(index);
+}
+
+//! constellation_lookup_point - Look up which constellation a point on the sky lies within
+//! \param index - The constellation lookup index
+//! \param ra - The right ascension of the point (radians, J2000.0)
+//! \param dec - The declination of the point (radians, J2000.0)
+//! \return - The numeric id of the constellation, or -1 if it could not be determined
+
+int constellation_lookup_point(const constellation_lookup *index, double ra, double dec) {
+    if ((!gsl_finite(ra)) || (!gsl_finite(dec))) return -1;
+    ra = fmod(ra, 2 * M_PI);
+    if (ra < 0) ra += 2 * M_PI;
+
+    int col = (int) (ra * (CONSTELLATION_LOOKUP_RA_CELLS / (2 * M_PI)));
+    int row = (int) ((dec + M_PI / 2) * (CONSTELLATION_LOOKUP_DEC_CELLS / M_PI));
+    col = (col < 0) ? 0 : ((col >= CONSTELLATION_LOOKUP_RA_CELLS) ? CONSTELLATION_LOOKUP_RA_CELLS - 1 : col);
+    row = (row < 0) ? 0 : ((row >= CONSTELLATION_LOOKUP_DEC_CELLS) ? CONSTELLATION_LOOKUP_DEC_CELLS - 1 : row);
+
+    const int cell = index->cells[row * CONSTELLATION_LOOKUP_RA_CELLS + col];
+    if (cell >= 0) return cell;
+
+    // This cell is crossed by a constellation boundary, so test the polygons which cross it
+    const int constellation_id = lookup_candidates(index, index->candidates + (-1 - cell), ra, dec);
+    if (constellation_id >= 0) return constellation_id;
+    return lookup_exhaustive(index, ra, dec);
+}
@@ -0,0 +1,60 @@
+// constellationLookup.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef CONSTELLATION_LOOKUP_H
+#define CONSTELLATION_LOOKUP_H 1
+
+#include <stdlib.h>
+#include <stdio.h>
+
+//! The number of cells the sky is divided into, in RA and Dec, by the index used to look up constellations
+#define CONSTELLATION_LOOKUP_RA_CELLS 1440
+#define CONSTELLATION_LOOKUP_DEC_CELLS 720
+
+//! constellation_polygon - The closed boundary of a constellation, with edges which are straight lines in RA/Dec
+typedef struct {
+    int constellation_id; // The numeric id of the constellation
+    int contains_pole; // +1 if the polygon encloses the north celestial pole, -1 the south pole, otherwise 0
+    double dec_min, dec_max; // The range of declinations spanned by the polygon (radians)
+    int vertex_count;
+    double *ra, *dec; // The vertices of the polygon (radians, J2000.0)
+} constellation_polygon;
+
+//! constellation_lookup - An index used to look up which constellation any point on the sky lies within. The sky is
+//! divided into cells. Cells which lie entirely within one constellation store its id directly; cells crossed by a
+//! boundary store a list of candidate polygons, which are tested in turn.
+typedef struct {
+    int polygon_count;
+    constellation_polygon *polygons;
+
+    // For each cell, either a constellation id (>= 0), or -(1 + offset) where <offset> is the position in
+    // <candidates> of the number of candidate polygons, which is followed by their indices
+    int *cells;
+    int *candidates;
+} constellation_lookup;
+
+constellation_lookup *constellation_lookup_open();
+
+void constellation_lookup_close(constellation_lookup *index);
+
+int constellation_lookup_point(const constellation_lookup *index, double ra, double dec);
+
+#endif
@@ -26,6 +26,7 @@
 
 #include <gsl/gsl_math.h>
 
+#include "astroGraphics/constellationGeometry.h"
 #include "coreUtils/asciiDouble.h"
 #include "coreUtils/errorReport.h"
 #include "mathsTools/projection.h"
@@ -57,78 +58,65 @@ static char *replace_at_with_space(const char *in) {
 //! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
 
 void plot_constellation_boundaries(chart_config *s, line_drawer *ld) {
-    FILE *file;
-    double x_first = 0, y_first = 0;
-    char line[FNAME_LENGTH], *scan, constellation[6] = "@@@@";
+    FILE *file = open_constellation_geometry();
+    constellation_geometry geometry = read_constellation_geometry_headers(file);
+    constellation_vertex *vertices = NULL;
+    int vertex_capacity = 0;
 
     // This must be set to true initially, to ensure that colour is set when we start tracing the first constellation
     int was_highlighted = 1;
 
-    // Set up line-drawing class
+    // Set up line-drawing class. Boundaries are stroked together until the line style changes.
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     ld_label(ld, NULL, 1, 1, 1);
+    ld_batch_strokes(ld, 1);
 
-    // Open file defining the celestial coordinates of the constellation boundaries
-    file = fopen(SRCDIR "../data/constellations/downloads/boundaries.dat", "r");
-    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation boundary data");
-
-    while ((!feof(file)) && (!ferror(file))) {
-        double ra, dec, x, y;
-        file_readline(file, line);
-        if ((line[0] == '#') || (strlen(line) < 28)) continue; // Comment line
-        scan = line + 0;
-        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
-        ra = get_float(scan, NULL);
-        scan = line + 12;
-        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
-        dec = get_float(scan, NULL);
-        if (line[11] == '-') dec = -dec;
-
-        // The boundary of Ursa Minor is a bit dodgy, and skirt around the pole star in the wrong direction.
-        // If we don't draw it, then the boundary of Cepheus is in the right place
-        if ((dec > 87) && (line[23] == 'U')) {
-            ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
-            continue;
-        }
+    // The boundary of Ursa Minor is a bit dodgy, and skirt around the pole star in the wrong direction.
+    // If we don't draw it, then the boundary of Cepheus is in the right place
+    const int ursa_minor = constellation_id_from_abbreviation("UMI");
+    const double ursa_minor_dec_limit = 87 * M_PI / 180;
+
+    for (int i = 0; i < geometry.group_count; i++) {
+        const constellation_geometry_info *group = &geometry.groups[i];
+        if (group->kind != CONSTELLATION_BOUNDARIES) continue;
+        if (!CONSTELLATION_MASK_TEST(s->constellation_mask, group->constellation_id)) continue;
+
+        // Skip constellations which lie entirely outside the field of view
+        if (!constellation_in_field_of_view(s, group)) continue;
 
-        plane_project(&x, &y, s, ra * M_PI / 12, dec * M_PI / 180, 0);
-
-        if (s->zodiacal_only && (strncmp(line + 23, "AQR ", 4) != 0) && (strncmp(line + 23, "ARI ", 4) != 0) &&
-            (strncmp(line + 23, "LEO ", 4) != 0) && (strncmp(line + 23, "CNC ", 4) != 0) &&
-            (strncmp(line + 23, "CAP ", 4) != 0) && (strncmp(line + 23, "GEM ", 4) != 0) &&
-            (strncmp(line + 23, "LIB ", 4) != 0) && (strncmp(line + 23, "OPH ", 4) != 0) &&
-            (strncmp(line + 23, "TAU ", 4) != 0) && (strncmp(line + 23, "SGR ", 4) != 0) &&
-            (strncmp(line + 23, "SCO ", 4) != 0) && (strncmp(line + 23, "VIR ", 4) != 0) &&
-            (strncmp(line + 23, "PSC ", 4) != 0))
-            continue;
-
-        if (strncmp(line + 23, constellation, 4) != 0) {
-            if (constellation[0] != '@') { ld_point(ld, x_first, y_first, NULL); }
-            strncpy(constellation, line + 23, 4);
-            constellation[5] = '\0';
-            ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
-            x_first = x;
-            y_first = y;
-
-            // Set the line colour and width for the boundary of this constellation
-            if (strncmp(constellation, s->constellation_highlight, 3) == 0) {
-                cairo_set_source_rgb(s->cairo_draw, s->star_col.red, s->star_col.grn,
-                                     s->star_col.blu);
-                cairo_set_line_width(s->cairo_draw, 2);
-                was_highlighted = 1;
-            } else if (was_highlighted) {
-                cairo_set_source_rgb(s->cairo_draw, s->constellation_boundary_col.red, s->constellation_boundary_col.grn,
-                                     s->constellation_boundary_col.blu);
-                cairo_set_line_width(s->cairo_draw, 0.8);
-                was_highlighted = 0;
-            }
+        read_constellation_vertices(file, &geometry, group, &vertices, &vertex_capacity);
+        ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+
+        // Set the line colour and width for the boundary of this constellation
+        if (group->constellation_id == s->constellation_highlight_id) {
+            ld_stroke(ld);
+            cairo_set_source_rgb(s->cairo_draw, s->star_col.red, s->star_col.grn,
+                                 s->star_col.blu);
+            cairo_set_line_width(s->cairo_draw, 2.88 * s->line_width_base);
+            was_highlighted = 1;
+        } else if (was_highlighted) {
+            ld_stroke(ld);
+            cairo_set_source_rgb(s->cairo_draw, s->constellation_boundary_col.red, s->constellation_boundary_col.grn,
+                                 s->constellation_boundary_col.blu);
+            cairo_set_line_width(s->cairo_draw, 1.15 * s->line_width_base);
+            was_highlighted = 0;
         }
 
-        ld_point(ld, x, y, NULL);
+        for (int j = 0; j < group->vertex_count; j++) {
+            double x, y;
+            const int skip = (group->constellation_id == ursa_minor) && (vertices[j].dec > ursa_minor_dec_limit);
+            if ((vertices[j].flags & CONSTELLATION_VERTEX_PEN_UP) || skip) ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+            if (skip) continue;
+            plane_project(&x, &y, s, vertices[j].ra, vertices[j].dec, 0);
+            ld_point(ld, x, y, NULL);
+        }
     }
 
-    fclose(file);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+    ld_batch_strokes(ld, 0);
+    free(vertices);
+    free_constellation_geometry_headers(&geometry);
+    fclose(file);
 }
 
 //! plot_constellation_sticks - Draw stick figures to represent the constellations.
@@ -136,61 +124,46 @@ void plot_constellation_boundaries(chart_config *s, line_drawer *ld) {
 //! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
 
 void plot_constellation_sticks(chart_config *s, line_drawer *ld) {
-    FILE *file;
-    char line[FNAME_LENGTH];
+    FILE *file = open_constellation_geometry();
+    constellation_geometry geometry = read_constellation_geometry_headers(file);
+    constellation_vertex *vertices = NULL;
+    int vertex_capacity = 0;
 
     // Set line colour
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->constellation_stick_col.red,
                          s->constellation_stick_col.grn, s->constellation_stick_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->constellation_sticks_line_width);
-
-    // Open file listing constellation stick figures by celestial coordinates
-    const char *stick_definitions = "constellation_lines_simplified_by_RA_Dec.dat";
-    if (s->constellation_stick_design == SW_STICKS_REY) stick_definitions = "constellation_lines_rey_by_RA_Dec.dat";
-
-    char stick_definitions_path[FNAME_LENGTH];
-    snprintf(stick_definitions_path, FNAME_LENGTH, "%s%s%s",
-             SRCDIR,
-             "../data/constellations/process_stick_figures/output/",
-             stick_definitions);
-
-    file = fopen(stick_definitions_path, "r");
-    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation stick figures");
-
-    while ((!feof(file)) && (!ferror(file))) {
-        double ra0, dec0, ra1, dec1, x0, y0, x1, y1;
-        file_readline(file, line);
-        if (line[0] == '#') continue; // Comment line
-        const char *scan = line;
-        while ((scan[0] != '\0') && (scan[0] <= ' ')) scan++;
-        if (s->zodiacal_only && (strncmp(scan, "Aqua", 4) != 0) && (strncmp(scan, "Arie", 4) != 0) &&
-            (strncmp(scan, "Leo ", 4) != 0) && (strncmp(scan, "Canc", 4) != 0) && (strncmp(scan, "Capr", 4) != 0) &&
-            (strncmp(scan, "Gemi", 4) != 0) && (strncmp(scan, "Libr", 4) != 0) && (strncmp(scan, "Ophi", 4) != 0) &&
-            (strncmp(scan, "Taur", 4) != 0) && (strncmp(scan, "Sagittar", 8) != 0) && (strncmp(scan, "Scor", 4) != 0) &&
-            (strncmp(scan, "Virg", 4) != 0) && (strncmp(scan, "Pisc", 4) != 0))
-            continue;
-        while ((scan[0] != '\0') && (scan[0] != '-') && (scan[0] != '.') && (scan[0] != '+') &&
-               ((scan[0] < '0') || (scan[0] > '9')))
-            scan++;
-        if (scan[0] == '\0') continue; // Blank line
-        ra0 = get_float(scan, NULL);
-        scan = next_word(scan);
-        dec0 = get_float(scan, NULL);
-        scan = next_word(scan);
-        ra1 = get_float(scan, NULL);
-        scan = next_word(scan);
-        dec1 = get_float(scan, NULL);
-        plane_project(&x0, &y0, s, ra0 * M_PI / 180, dec0 * M_PI / 180, 0);
-        plane_project(&x1, &y1, s, ra1 * M_PI / 180, dec1 * M_PI / 180, 0);
-        ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
-        ld_point(ld, x0, y0, NULL);
-        ld_point(ld, x1, y1, NULL);
-        ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+    cairo_set_line_width(s->cairo_draw, s->constellation_sticks_line_width * s->line_width_base);
+
+    // All the sticks share the same style, so are stroked together
+    ld_batch_strokes(ld, 1);
+
+    // Select which design of stick figures to draw
+    int stick_kind = CONSTELLATION_STICKS_SIMPLIFIED;
+    if (s->constellation_stick_design == SW_STICKS_REY) stick_kind = CONSTELLATION_STICKS_REY;
+
+    for (int i = 0; i < geometry.group_count; i++) {
+        const constellation_geometry_info *group = &geometry.groups[i];
+        if (group->kind != stick_kind) continue;
+        if (!CONSTELLATION_MASK_TEST(s->constellation_mask, group->constellation_id)) continue;
+
+        // Skip constellations which lie entirely outside the field of view
+        if (!constellation_in_field_of_view(s, group)) continue;
+
+        read_constellation_vertices(file, &geometry, group, &vertices, &vertex_capacity);
+        for (int j = 0; j < group->vertex_count; j++) {
+            double x, y;
+            if (vertices[j].flags & CONSTELLATION_VERTEX_PEN_UP) ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+            plane_project(&x, &y, s, vertices[j].ra, vertices[j].dec, 0);
+            ld_point(ld, x, y, NULL);
+        }
     }
 
-    fclose(file);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+    ld_batch_strokes(ld, 0);
+    free(vertices);
+    free_constellation_geometry_headers(&geometry);
+    fclose(file);
 }
 
 //! plot_constellation_names - Write the names of the constellations on the star chart.
@@ -198,43 +171,30 @@ void plot_constellation_sticks(chart_config *s, line_drawer *ld) {
 //! \param page - A <cairo_page> structure defining the cairo drawing context.
 
 void plot_constellation_names(chart_config *s, cairo_page *page) {
-    FILE *file;
-    char line[FNAME_LENGTH];
-
-    strcpy(line, SRCDIR "../data/constellations/name_places.dat");
-    if (s->language == SW_LANG_FR) strcpy(line, SRCDIR "../data/constellations/name_places_fr.dat");
-    file = fopen(line, "r");
-    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open constellation name data");
-
-    while ((!feof(file)) && (!ferror(file))) {
-        file_readline(file, line);
-        if (line[0] == '#') continue; // Comment line
-        const char *scan = line;
-        while ((scan[0] > '\0') && (scan[0] <= ' ')) scan++;
-        const char *name = scan;
-        if (scan[0] == '\0') continue; // Blank line
-        scan = next_word(scan);
-
-        if (s->zodiacal_only && (strncmp(name, "Aqua", 4) != 0) && (strncmp(name, "Arie", 4) != 0) &&
-            (strncmp(name, "Leo ", 4) != 0) && (strncmp(name, "Canc", 4) != 0) && (strncmp(name, "Capr", 4) != 0) &&
-            (strncmp(name, "Gemi", 4) != 0) && (strncmp(name, "Libr", 4) != 0) && (strncmp(name, "Ophi", 4) != 0) &&
-            (strncmp(name, "Taur", 4) != 0) && (strncmp(name, "Sagittar", 8) != 0) && (strncmp(name, "Scor", 4) != 0) &&
-            (strncmp(name, "Virg", 4) != 0) && (strncmp(name, "Pisc", 4) != 0))
-            continue;
-
-        while (1) {
-            double ra, dec, x, y;
-            if (scan[0] == '\0') break; // End of line
-            ra = get_float(scan, NULL);
-            scan = next_word(scan);
-            dec = get_float(scan, NULL);
-            plane_project(&x, &y, s, ra * M_PI / 12, dec * M_PI / 180, 0);
-            if ((x < s->x_min) || (x > s->x_max) || (y < s->y_min) || (y > s->y_max)) {
-                scan = next_word(scan);
-                continue;
-            }
-
-            char *label = replace_at_with_space(name);
+    FILE *file = open_constellation_geometry();
+    constellation_geometry geometry = read_constellation_geometry_headers(file);
+    constellation_vertex *vertices = NULL;
+    int vertex_capacity = 0;
+
+    const int names_kind = (s->language == SW_LANG_FR) ? CONSTELLATION_NAMES_FR : CONSTELLATION_NAMES_EN;
+
+    for (int i = 0; i < geometry.group_count; i++) {
+        const constellation_geometry_info *group = &geometry.groups[i];
+        if (group->kind != names_kind) continue;
+        if (!CONSTELLATION_MASK_TEST(s->constellation_mask, group->constellation_id)) continue;
+
+        // Skip constellations whose candidate name positions all lie outside the field of view
+        if (!constellation_in_field_of_view(s, group)) continue;
+
+        // Label the constellation at the first candidate position which falls within the plot area
+        read_constellation_vertices(file, &geometry, group, &vertices, &vertex_capacity);
+        for (int j = 0; j < group->vertex_count; j++) {
+            double x, y;
+            if (!constellation_vertex_in_field_of_view(s, &vertices[j])) continue;
+            plane_project(&x, &y, s, vertices[j].ra, vertices[j].dec, 0);
+            if ((x < s->x_min) || (x > s->x_max) || (y < s->y_min) || (y > s->y_max)) continue;
+
+            char *label = replace_at_with_space(group->name);
 
             chart_label_buffer(page, s, s->constellation_label_col, label,
                                &(label_position) {x, y, 0, 0, 0}, 1,
@@ -243,5 +203,8 @@ void plot_constellation_names(chart_config *s, cairo_page *page) {
             break;
         }
     }
+
+    free(vertices);
+    free_constellation_geometry_headers(&geometry);
     fclose(file);
 }
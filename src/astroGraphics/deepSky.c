@@ -26,6 +26,7 @@
 #include <gsl/gsl_math.h>
 
 #include "astroGraphics/deepSky.h"
+#include "astroGraphics/deepSkyReader.h"
 #include "coreUtils/asciiDouble.h"
 #include "coreUtils/errorReport.h"
 #include "mathsTools/projection.h"
@@ -38,7 +39,7 @@
 //! \param messier_only - Boolean flag indicating whether we're only displaying Messier objects
 
 void draw_open_cluster(chart_config *s, double x_canvas, double y_canvas, const double radius) {
-    cairo_set_line_width(s->cairo_draw, 1);
+    cairo_set_line_width(s->cairo_draw, 1.44 * s->line_width_base);
     cairo_new_path(s->cairo_draw);
     cairo_arc(s->cairo_draw, x_canvas, y_canvas, radius, 0, 2 * M_PI);
     cairo_set_source_rgb(s->cairo_draw, s->dso_cluster_col.red, s->dso_cluster_col.grn, s->dso_cluster_col.blu);
@@ -48,14 +49,14 @@ void draw_open_cluster(chart_config *s, double x_canvas, double y_canvas, const
 }
 
 void draw_globular_cluster(chart_config *s, double x_canvas, double y_canvas, const double radius) {
-    cairo_set_line_width(s->cairo_draw, 1);
+    cairo_set_line_width(s->cairo_draw, 1.44 * s->line_width_base);
     cairo_new_path(s->cairo_draw);
     cairo_arc(s->cairo_draw, x_canvas, y_canvas, radius, 0, 2 * M_PI);
     cairo_set_source_rgb(s->cairo_draw, s->dso_cluster_col.red, s->dso_cluster_col.grn, s->dso_cluster_col.blu);
     cairo_fill_preserve(s->cairo_draw);
     cairo_set_source_rgb(s->cairo_draw, s->dso_outline_col.red, s->dso_outline_col.grn, s->dso_outline_col.blu);
     cairo_stroke(s->cairo_draw);
-    cairo_set_line_width(s->cairo_draw, 0.5);
+    cairo_set_line_width(s->cairo_draw, 0.72 * s->line_width_base);
     cairo_new_path(s->cairo_draw);
     cairo_move_to(s->cairo_draw, x_canvas - radius, y_canvas);
     cairo_line_to(s->cairo_draw, x_canvas + radius, y_canvas);
@@ -75,13 +76,13 @@ void draw_galaxy(chart_config *s, double axis_pa, double x_canvas, double y_canv
     cairo_restore(s->cairo_draw);
     cairo_set_source_rgb(s->cairo_draw, s->dso_galaxy_col.red, s->dso_galaxy_col.grn, s->dso_galaxy_col.blu);
     cairo_fill_preserve(s->cairo_draw);
-    cairo_set_line_width(s->cairo_draw, 0.5);
+    cairo_set_line_width(s->cairo_draw, 0.72 * s->line_width_base);
     cairo_set_source_rgb(s->cairo_draw, s->dso_outline_col.red, s->dso_outline_col.grn, s->dso_outline_col.blu);
     cairo_stroke(s->cairo_draw);
 }
 
 void draw_generic_nebula(chart_config *s, double x_canvas, double y_canvas, double point_size) {
-    cairo_set_line_width(s->cairo_draw, 0.5);
+    cairo_set_line_width(s->cairo_draw, 0.72 * s->line_width_base);
     cairo_new_path(s->cairo_draw);
     cairo_move_to(s->cairo_draw, x_canvas - point_size, y_canvas - point_size);
     cairo_line_to(s->cairo_draw, x_canvas + point_size, y_canvas - point_size);
@@ -95,61 +96,37 @@ void draw_generic_nebula(chart_config *s, double x_canvas, double y_canvas, doub
 }
 
 void plot_deep_sky_objects(chart_config *s, cairo_page *page, int messier_only) {
-    // Path to where deep sky object catalogue is stored
-    const char *dso_object_catalogue = SRCDIR "../data/deepSky/ngcDistances/output/ngc_merged.txt";
-
-    // Open data file listing the positions of the NGC and IC objects
-    FILE *file = fopen(dso_object_catalogue, "r");
-    if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open deep sky catalogue");
+    // Open the binary catalogue of NGC and IC objects, and read those in tiles within the field of view
+    FILE *file = open_binary_dso_catalogue();
+    dso_catalogue_information catalogue = read_binary_dso_catalogue_headers(file);
+    int dso_count = 0;
+    dso_definition *dsos = read_dsos_in_field_of_view(s, file, &catalogue, &dso_count);
+    fclose(file);
 
     // Count the number of DSOs we have drawn and labelled, and make sure it doesn't exceed user-specified limits
     int dso_counter = 0;
     int label_counter = 0;
 
-    // Loop over the lines of the data file
-    while ((!feof(file)) && (!ferror(file))) {
-        char line[FNAME_LENGTH];
-        const char *line_ptr = line;
-
-        file_readline(file, line);
-
-        // Ignore comment lines
-        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\0')) continue;
-
-        // Extract data from line of text
-        while (*line_ptr == ' ') line_ptr++;
-        int messier_num = (int) get_float(line_ptr, NULL);
-        line_ptr = next_word(line_ptr);
-        int ngc_num = (int) get_float(line_ptr, NULL);
-        line_ptr = next_word(line_ptr);
-        int ic_num = (int) get_float(line_ptr, NULL);
-        line_ptr = next_word(line_ptr);
-        double ra = get_float(line_ptr, NULL); // hours; J2000
-        line_ptr = next_word(line_ptr);
-        double dec = get_float(line_ptr, NULL); // degrees; J2000
-        line_ptr = next_word(line_ptr);
-        double mag = get_float(line_ptr, NULL); // magnitude
-        line_ptr = next_word(line_ptr);
-        double axis_major = get_float(line_ptr, NULL); // arcminutes
-        line_ptr = next_word(line_ptr);
-        double axis_minor = get_float(line_ptr, NULL); // arcminutes
-        line_ptr = next_word(line_ptr);
-        double axis_pa = get_float(line_ptr, NULL); // position angle; degrees
-        const char *type_string = next_word(line_ptr);
+    // Loop over the objects in order of brightness
+    for (int dso_index = 0; dso_index < dso_count; dso_index++) {
+        const dso_definition *dso = &dsos[dso_index];
+        const double ra = dso->ra; // radians; J2000
+        const double dec = dso->dec; // radians; J2000
+        const double mag = dso->mag; // magnitude
+        const double axis_major = dso->axis_major; // arcminutes
+        const double axis_minor = dso->axis_minor; // arcminutes
+        const double axis_pa = dso->axis_pa; // position angle; degrees
+        const char *type_string = catalogue.string_table + dso->type_offset;
+        const char *object_name = catalogue.string_table + dso->name_offset;
 
         // If we're only showing Messier objects; only show them
-        if (messier_only && (messier_num == 0)) {
-            continue;
-        }
-
-        // Too faint; include objects with no magnitudes given (recorded as 0) if mag cutoff > mag 50.
-        if ((s->dso_mag_min < 50) && (s->dso_mag_min < mag)) {
+        if (messier_only && (dso->messier_num == 0)) {
             continue;
         }
 
         // Project RA and Dec of object into physical coordinates on the star chart
         double x, y;
-        plane_project(&x, &y, s, ra * M_PI / 12, dec * M_PI / 180, 0);
+        plane_project(&x, &y, s, ra, dec, 0);
 
         // Reject this object if it falls outside the plot area
         if ((!gsl_finite(x)) || (!gsl_finite(y))) {
@@ -160,20 +137,11 @@ void plot_deep_sky_objects(chart_config *s, cairo_page *page, int messier_only)
             continue;
         }
 
-        // Check if we've exceeded maximum number of objects
-        if (dso_counter > s->maximum_dso_count) continue;
+        // Check if we've exceeded maximum number of objects. Objects are sorted by brightness, so the remaining
+        // objects are all fainter.
+        if (dso_counter > s->maximum_dso_count) break;
         dso_counter++;
 
-        // Create a name for this object
-        char object_name[FNAME_LENGTH] = "";
-        if (messier_num > 0) {
-            snprintf(object_name, FNAME_LENGTH, "M%d", messier_num);
-        } else if (ngc_num > 0) {
-            snprintf(object_name, FNAME_LENGTH, "NGC%d", ngc_num);
-        } else if (ic_num > 0) {
-            snprintf(object_name, FNAME_LENGTH, "IC%d", ic_num);
-        }
-
         // Draw a symbol showing the position of this object
         double x_canvas, y_canvas, rendered_symbol_width = 0;
         const double pt = 1. / 72; // 1 pt
@@ -204,7 +172,7 @@ void plot_deep_sky_objects(chart_config *s, cairo_page *page, int messier_only)
 
             // Work out direction of north on the chart
             double x2, y2;
-            plane_project(&x2, &y2, s, ra * M_PI / 12, (dec + 1e-3) * M_PI / 180, 0);
+            plane_project(&x2, &y2, s, ra, dec + 1e-3 * M_PI / 180, 0);
 
             // Check output is finite
             if ((!gsl_finite(x2)) || (!gsl_finite(y2))) {
@@ -264,8 +232,9 @@ void plot_deep_sky_objects(chart_config *s, cairo_page *page, int messier_only)
         }
     }
 
-    // Close data file listing deep sky objects
-    fclose(file);
+    // Free the list of deep sky objects
+    free(dsos);
+    free_binary_dso_catalogue_headers(&catalogue);
 
     // print debugging message
     if (DEBUG) {
@@ -323,7 +292,7 @@ double draw_dso_symbol_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
     }
 
     // Advance horizontally to draw the next item in the legend
@@ -341,7 +310,7 @@ double draw_dso_symbol_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
     }
 
     // Advance horizontally to draw the next item in the legend
@@ -359,7 +328,7 @@ double draw_dso_symbol_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
     }
 
     // Advance horizontally to draw the next item in the legend
@@ -377,7 +346,7 @@ double draw_dso_symbol_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
     }
 
     // Advance horizontally to draw the next item in the legend
@@ -21,6 +21,9 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
 #include <glob.h>
 #include <wordexp.h>
 
@@ -29,10 +32,54 @@
 #include "astroGraphics/deepSkyOutlines.h"
 #include "coreUtils/asciiDouble.h"
 #include "coreUtils/errorReport.h"
+#include "listTools/ltMemory.h"
 #include "mathsTools/projection.h"
 #include "settings/chart_config.h"
 #include "vectorGraphics/cairo_page.h"
 
+// Binary file format version number
+static const int dso_outlines_binary_format_version = 1;
+
+// Filenames
+static const char *ascii_dso_outlines = SRCDIR "/../data/deepSky/ngc/outlines/*.txt";
+static const char *binary_dso_outlines = SRCDIR "/../data/deepSky/ngc/outlines.bin";
+
+//! The smallest number of points for which we allocate space in the scratch buffers used to draw outlines
+#define OUTLINE_SCRATCH_MIN_POINTS 4096
+
+//! outline_scratch - Scratch buffers used while drawing outlines, which are reused across outlines and grow as
+//! required. They are allocated in the current lt_memory context, and so are freed when the chart is finished.
+typedef struct {
+    int capacity; // The number of points the buffers have space for
+    dso_outline_point *points; // The points read from the outline store
+    double *x_canvas, *y_canvas; // The positions of the points on the cairo canvas
+} outline_scratch;
+
+//! outline_scratch_reserve - Ensure that scratch buffers have space for a given number of points
+//! \param scratch - The scratch buffers
+//! \param point_count - The number of points required
+
+static void outline_scratch_reserve(outline_scratch *scratch, int point_count) {
+    if (point_count <= scratch->capacity) return;
+
+    // Check that the buffers' sizes fit in the int which lt_malloc accepts
+    if ((point_count < 0) || (point_count > INT_MAX / 2 / (int) sizeof(dso_outline_point))) {
+        stch_fatal(__FILE__, __LINE__, "Deep sky object outline has too many points");
+    }
+
+    // Grow geometrically, so that the space abandoned in the memory context is bounded by what we end up using
+    int capacity = (int) gsl_max(OUTLINE_SCRATCH_MIN_POINTS, gsl_max(point_count, 2. * scratch->capacity));
+    capacity = (int) gsl_min(capacity, INT_MAX / 2 / (int) sizeof(dso_outline_point));
+
+    scratch->points = (dso_outline_point *) lt_malloc(capacity * (int) sizeof(dso_outline_point));
+    scratch->x_canvas = (double *) lt_malloc(capacity * (int) sizeof(double));
+    scratch->y_canvas = (double *) lt_malloc(capacity * (int) sizeof(double));
+    if ((scratch->points == NULL) || (scratch->x_canvas == NULL) || (scratch->y_canvas == NULL)) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+    scratch->capacity = capacity;
+}
+
 //! close_dso_outline - Close the path around a deep sky object
 //! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
 
@@ -41,136 +88,290 @@ void close_dso_outline(chart_config *s) {
                          s->dso_nebula_col.blu);
     cairo_fill_preserve(s->cairo_draw);
     cairo_set_source_rgb(s->cairo_draw, s->dso_outline_col.red, s->dso_outline_col.grn, s->dso_outline_col.blu);
-    cairo_set_line_width(s->cairo_draw, 0.8);
+    cairo_set_line_width(s->cairo_draw, 1.15 * s->line_width_base);
     cairo_stroke(s->cairo_draw);
 }
 
-//! plot_deep_sky_outlines - Draw outlines of deep sky objects onto a star chart
-//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
-//! \param page - A <cairo_page> structure defining the cairo drawing context.
+//! open_binary_dso_outlines - Open the binary store of deep sky object outlines (for reading), creating it from the
+//! ASCII outline files if it does not exist
+//! \return - File handle
 
-void plot_deep_sky_outlines(chart_config *s, cairo_page *page) {
+static FILE *open_binary_dso_outlines() {
+    FILE *file = fopen(binary_dso_outlines, "r");
+
+    // If binary file was opened, check the version number is correct
+    if (file != NULL) {
+        int version_number;
+        if ((fread(&version_number, sizeof(int), 1, file) != 1) ||
+            (version_number != dso_outlines_binary_format_version)) {
+            fclose(file);
+            file = NULL;
+        }
+    }
+
+    // If binary file did not open successfully, recreate it from the ASCII outlines
+    if (file == NULL) {
+        dso_outlines_to_binary();
+        file = fopen(binary_dso_outlines, "r");
+        if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary deep sky outlines for reading");
+    }
+
+    // Return to the beginning of the file
+    fseek(file, 0, SEEK_SET);
+    return file;
+}
+
+//! read_binary_dso_outline_headers - Read the header of the binary outline store
+//! \param file - File handle to read the header from
+//! \return - A <dso_outline_store_information> structure
+
+static dso_outline_store_information read_binary_dso_outline_headers(FILE *file) {
+    fseek(file, 0, SEEK_SET);
+
+    dso_outline_store_information store;
+    fread(&store.binary_version, sizeof(int), 1, file);
+    fread(&store.outline_count, sizeof(int), 1, file);
+    fread(&store.file_points_start_position, sizeof(unsigned long int), 1, file);
+
+    store.outline_info = malloc(gsl_max(1, store.outline_count) * sizeof(dso_outline_info));
+    if (store.outline_info == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    fread(store.outline_info, store.outline_count * sizeof(dso_outline_info), 1, file);
+    return store;
+}
+
+//! write_binary_dso_outline_headers - Write the header of the binary outline store
+//! \param store - A <dso_outline_store_information> structure to write out
+//! \param out - File handle to write the headers to
+
+static void write_binary_dso_outline_headers(const dso_outline_store_information *store, FILE *out) {
+    fseek(out, 0, SEEK_SET);
+
+    fwrite(&store->binary_version, sizeof(int), 1, out);
+    fwrite(&store->outline_count, sizeof(int), 1, out);
+    fwrite(&store->file_points_start_position, sizeof(unsigned long int), 1, out);
+    fwrite(store->outline_info, store->outline_count * sizeof(dso_outline_info), 1, out);
+}
+
+//! dso_outlines_to_binary - Pack the text-based outlines of deep sky objects in <data/deepSky/ngc/outlines> into a
+//! single binary file, recording the cap on the sky which encloses each outline. This means we can reject outlines
+//! which fall outside the field of view without reading their points.
+
+void dso_outlines_to_binary() {
     wordexp_t w;
     glob_t g;
 
-    // Path to where deep sky object outlines are stored
-    const char *outlines_path = SRCDIR "/../data/deepSky/ngc/outlines/*.txt";
+    dso_outline_store_information store;
+    int outline_capacity = 256, point_capacity = 65536, point_count = 0;
+    store.binary_version = dso_outlines_binary_format_version;
+    store.outline_count = 0;
+    store.file_points_start_position = 0;
+    store.outline_info = malloc(outline_capacity * sizeof(dso_outline_info));
+    dso_outline_point *points = malloc(point_capacity * sizeof(dso_outline_point));
+    if ((store.outline_info == NULL) || (points == NULL)) stch_fatal(__FILE__, __LINE__, "Malloc fail");
 
     // Fetch list of all the deep sky object outlines we have
-    if (wordexp(outlines_path, &w, 0) != 0) return; // No matches; return empty list
-    for (int i = 0; i < w.we_wordc; i++) {
-        if (glob(w.we_wordv[i], 0, NULL, &g) != 0) continue;
-        for (int j = 0; j < g.gl_pathc; j++) {
-            // Deep sky object outline we are processing
-            const char *outline_file = g.gl_pathv[j];
-
-            // Logging message
-            if (DEBUG) {
-                char message[FNAME_LENGTH];
-                snprintf(message, FNAME_LENGTH, "Drawing outline from <%s>", outline_file);
-                stch_log(message);
-            }
+    if (wordexp(ascii_dso_outlines, &w, 0) == 0) {
+        for (int i = 0; i < w.we_wordc; i++) {
+            if (glob(w.we_wordv[i], 0, NULL, &g) != 0) continue;
+            for (int j = 0; j < g.gl_pathc; j++) {
+                // Deep sky object outline we are processing
+                const char *outline_file = g.gl_pathv[j];
+                FILE *file = fopen(outline_file, "r");
+                if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open deep sky object outline");
 
-            // Open file
-            FILE *file = fopen(outline_file, "r");
-            if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open deep sky object outline");
-
-            // Initially, read path into an array
-            const int max_points = 4096;
-            double ra[max_points], dec[max_points];
-            double x[max_points], y[max_points];
-            double x_canvas[max_points], y_canvas[max_points];
-            int continuous[max_points];
-
-            // Loop over the lines of the data file
-            int point_counter = 0;
-            int reject_object = 0;
-            while ((!feof(file)) && (!ferror(file))) {
-                char line[FNAME_LENGTH];
-                const char *line_ptr = line;
-
-                file_readline(file, line);
-
-                // Ignore comment lines
-                if (line[0] != 'l') continue;
-
-                // Extract data from line
-                line_ptr = next_word(line_ptr);
-                continuous[point_counter] = (line_ptr[0] == '+');
-                line_ptr = next_word(line_ptr);
-                ra[point_counter] = get_float(line_ptr, NULL);
-                line_ptr = next_word(line_ptr);
-                dec[point_counter] = get_float(line_ptr, NULL);
-
-                // Project RA and Dec of object into physical coordinates on the star chart
-                plane_project(&x[point_counter], &y[point_counter], s,
-                              ra[point_counter] * M_PI / 180, dec[point_counter] * M_PI / 180, 0);
-
-                // Reject this object if it falls outside the plot area
-                if ((!gsl_finite(x[point_counter])) || (!gsl_finite(y[point_counter]))) {
-                    reject_object = 1;
-                    break;
+                if (store.outline_count >= outline_capacity) {
+                    outline_capacity *= 2;
+                    store.outline_info = realloc(store.outline_info, outline_capacity * sizeof(dso_outline_info));
+                    if (store.outline_info == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
                 }
+                dso_outline_info *info = &store.outline_info[store.outline_count++];
+                memset((void *) info, 0, sizeof(dso_outline_info)); // Ensures md5 checksum is the same on each run
+                const char *basename = strrchr(outline_file, '/');
+                snprintf(info->name, sizeof(info->name), "%s", (basename != NULL) ? basename + 1 : outline_file);
+                info->file_position = point_count;
 
-                if (
-                        (x[point_counter] < s->x_min * 1.2) || (x[point_counter] > s->x_max * 1.2) ||
-                        (y[point_counter] < s->y_min * 1.2) || (y[point_counter] > s->y_max * 1.2)
-                        ) {
-                    reject_object = 1;
-                    break;
-                }
+                // Loop over the lines of the data file
+                while ((!feof(file)) && (!ferror(file))) {
+                    char line[FNAME_LENGTH];
+                    const char *line_ptr = line;
+
+                    file_readline(file, line);
+
+                    // Ignore comment lines
+                    if (line[0] != 'l') continue;
 
-                // Convert coordinates from tangent plane into pixels on the Cairo canvas
-                fetch_canvas_coordinates(&x_canvas[point_counter], &y_canvas[point_counter],
-                                         x[point_counter], y[point_counter], s);
+                    if (point_count >= point_capacity) {
+                        point_capacity *= 2;
+                        points = realloc(points, point_capacity * sizeof(dso_outline_point));
+                        if (points == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+                    }
 
-                // Check that we haven't jumped off one side of star chart, and on the other side
-                if (point_counter > 0) {
-                    double line_length = hypot(y_canvas[point_counter - 1] - y_canvas[point_counter],
-                                               x_canvas[point_counter - 1] - x_canvas[point_counter]);
-                    if (line_length > 100) reject_object = 1;
+                    // Extract data from line
+                    dso_outline_point *point = &points[point_count++];
+                    memset((void *) point, 0, sizeof(dso_outline_point));
+                    line_ptr = next_word(line_ptr);
+                    point->continuous = (line_ptr[0] == '+');
+                    line_ptr = next_word(line_ptr);
+                    point->ra = (float) (get_float(line_ptr, NULL) * M_PI / 180);
+                    line_ptr = next_word(line_ptr);
+                    point->dec = (float) (get_float(line_ptr, NULL) * M_PI / 180);
+
+                    // Accumulate the mean direction of the points in this outline
+                    info->centre[0] += cos(point->dec) * cos(point->ra);
+                    info->centre[1] += cos(point->dec) * sin(point->ra);
+                    info->centre[2] += sin(point->dec);
+                    info->point_count++;
                 }
+                fclose(file);
 
-                // Update point counter
-                point_counter++;
+                // Work out the cap, centred on the mean direction, which encloses every point
+                const double norm = sqrt(gsl_pow_2(info->centre[0]) + gsl_pow_2(info->centre[1]) +
+                                         gsl_pow_2(info->centre[2]));
+                for (int k = 0; k < 3; k++) info->centre[k] = (norm > 0) ? info->centre[k] / norm : 0;
+                info->radius = (norm > 0) ? 0 : M_PI;
+                for (int k = 0; k < info->point_count; k++) {
+                    const dso_outline_point *point = &points[info->file_position + k];
+                    const double cos_distance = (info->centre[0] * cos(point->dec) * cos(point->ra) +
+                                                 info->centre[1] * cos(point->dec) * sin(point->ra) +
+                                                 info->centre[2] * sin(point->dec));
+                    info->radius = gsl_max(info->radius, acos(gsl_max(-1, gsl_min(1, cos_distance))));
+                }
             }
+            globfree(&g);
+        }
+        wordfree(&w);
+    }
 
-            // If this object has been rejected, ignore it
-            if (reject_object) continue;
+    // Start writing binary output file
+    FILE *out = fopen(binary_dso_outlines, "wb");
+    if (out == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary deep sky outlines for output");
 
-            // Start drawing a path around the outline of this object
-            cairo_new_path(s->cairo_draw);
+    // Write the header to find out where the points start, and then rewrite it with the position set
+    write_binary_dso_outline_headers(&store, out);
+    store.file_points_start_position = ftell(out);
+    write_binary_dso_outline_headers(&store, out);
 
-            // Loop over all the points in the path
-            int line_point_counter = 0;
-            for (int k = 0; k < point_counter; k++) {
+    // Write the points of all the outlines
+    fseek(out, (long) store.file_points_start_position, SEEK_SET);
+    if (point_count > 0) fwrite(points, point_count * sizeof(dso_outline_point), 1, out);
+    fclose(out);
 
-                // Either continue an existing line, or start a new path
-                if (line_point_counter == 0) {
-                    cairo_move_to(s->cairo_draw, x_canvas[k], y_canvas[k]);
-                } else {
-                    cairo_line_to(s->cairo_draw, x_canvas[k], y_canvas[k]);
-                }
+    // Free up the temporary arrays we used
+    free(store.outline_info);
+    free(points);
+}
 
-                // Close path, if requested
-                if (!continuous[k]) {
-                    close_dso_outline(s);
-                    line_point_counter = 0;
-                }
+//! plot_deep_sky_outlines - Draw outlines of deep sky objects onto a star chart
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param page - A <cairo_page> structure defining the cairo drawing context.
+
+void plot_deep_sky_outlines(chart_config *s, cairo_page *page) {
+    // Read the index of outlines from the binary outline store
+    FILE *file = open_binary_dso_outlines();
+    dso_outline_store_information store = read_binary_dso_outline_headers(file);
+
+    // Work out the cap on the sky which encloses the field of view. Outlines are stored in RA/Dec, so we can only
+    // compare them against the field of view if the chart is centred in the same coordinates. We allow some margin
+    // since outlines are drawn if they lie within 1.2 times the plot area.
+    const double field_radius = (s->coords == SW_COORDS_GAL) ? M_PI : gsl_min(M_PI, 1.2 * field_of_view_radius(s));
+    const double field_centre[3] = {cos(s->dec0) * cos(s->ra0), cos(s->dec0) * sin(s->ra0), sin(s->dec0)};
+
+    // Scratch buffers, reused for each outline we draw
+    outline_scratch scratch = {0, NULL, NULL, NULL};
+
+    for (int j = 0; j < store.outline_count; j++) {
+        const dso_outline_info *outline = &store.outline_info[j];
+
+        // Reject outlines whose bounding cap does not intersect the field of view, without reading their points
+        if (field_radius < M_PI) {
+            const double cos_distance = (outline->centre[0] * field_centre[0] + outline->centre[1] * field_centre[1] +
+                                         outline->centre[2] * field_centre[2]);
+            const double distance = acos(gsl_max(-1, gsl_min(1, cos_distance)));
+            if (distance > field_radius + outline->radius) continue;
+        }
+
+        // Logging message
+        if (DEBUG) {
+            char message[FNAME_LENGTH];
+            snprintf(message, FNAME_LENGTH, "Drawing outline from <%s>", outline->name);
+            stch_log(message);
+        }
 
-                // Update point counter
-                line_point_counter++;
+        // Initially, read path into an array
+        outline_scratch_reserve(&scratch, outline->point_count);
+        dso_outline_point *points = scratch.points;
+        double *x_canvas = scratch.x_canvas, *y_canvas = scratch.y_canvas;
+
+        fseek(file, (long) (store.file_points_start_position + outline->file_position * sizeof(dso_outline_point)),
+              SEEK_SET);
+        if (fread(points, sizeof(dso_outline_point), outline->point_count, file) != outline->point_count) {
+            stch_fatal(__FILE__, __LINE__, "Could not read deep sky object outline");
+        }
+
+        // Loop over the points in the outline
+        int point_counter = 0;
+        int reject_object = 0;
+        for (point_counter = 0; point_counter < outline->point_count; point_counter++) {
+            // Project RA and Dec of object into physical coordinates on the star chart
+            double x, y;
+            plane_project(&x, &y, s, points[point_counter].ra, points[point_counter].dec, 0);
+
+            // Reject this object if it falls outside the plot area
+            if ((!gsl_finite(x)) || (!gsl_finite(y))) {
+                reject_object = 1;
+                break;
+            }
+
+            if ((x < s->x_min * 1.2) || (x > s->x_max * 1.2) || (y < s->y_min * 1.2) || (y > s->y_max * 1.2)) {
+                reject_object = 1;
+                break;
             }
 
-            // Finally, stroke and fill path
-            if (line_point_counter > 0) {
+            // Convert coordinates from tangent plane into pixels on the Cairo canvas
+            fetch_canvas_coordinates(&x_canvas[point_counter], &y_canvas[point_counter], x, y, s);
+
+            // Check that we haven't jumped off one side of star chart, and on the other side
+            if (point_counter > 0) {
+                double line_length = hypot(y_canvas[point_counter - 1] - y_canvas[point_counter],
+                                           x_canvas[point_counter - 1] - x_canvas[point_counter]);
+                if (line_length > 100) reject_object = 1;
+            }
+        }
+
+        // If this object has been rejected, ignore it
+        if (reject_object) continue;
+
+        // Start drawing a path around the outline of this object
+        cairo_new_path(s->cairo_draw);
+
+        // Loop over all the points in the path
+        int line_point_counter = 0;
+        for (int k = 0; k < point_counter; k++) {
+
+            // Either continue an existing line, or start a new path
+            if (line_point_counter == 0) {
+                cairo_move_to(s->cairo_draw, x_canvas[k], y_canvas[k]);
+            } else {
+                cairo_line_to(s->cairo_draw, x_canvas[k], y_canvas[k]);
+            }
+
+            // Close path, if requested
+            if (!points[k].continuous) {
                 close_dso_outline(s);
+                line_point_counter = 0;
             }
 
-            // Close outline file
-            fclose(file);
+            // Update point counter
+            line_point_counter++;
+        }
+
+        // Finally, stroke and fill path
+        if (line_point_counter > 0) {
+            close_dso_outline(s);
         }
-        globfree(&g);
     }
-    wordfree(&w);
+
+    // Close the outline store
+    fclose(file);
+    free(store.outline_info);
 }
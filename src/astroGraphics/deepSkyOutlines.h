@@ -29,6 +29,35 @@
 #include "vectorGraphics/lineDraw.h"
 #include "vectorGraphics/cairo_page.h"
 
+//! dso_outline_info - Information about where an outline is to be found in the binary outline store, and the cap on
+//! the celestial sphere which encloses it
+typedef struct {
+    char name[64]; // The name of the file the outline was read from
+    double centre[3]; // Unit vector pointing at the centre of the bounding cap, in J2000 equatorial coordinates
+    double radius; // Angular radius of the bounding cap (radians)
+    int point_count; // The number of points in this outline
+
+    // The location in the binary file where the points in this outline start
+    // Stored in units of sizeof(dso_outline_point) beyond the start point of <file_points_start_position> bytes
+    int file_position;
+} dso_outline_info;
+
+//! dso_outline_point - A single point along the outline of a deep sky object
+typedef struct {
+    float ra, dec; // radians, J2000.0
+    int continuous; // Boolean flag indicating whether the path continues to the next point, or is closed here
+} dso_outline_point;
+
+//! dso_outline_store_information - Information stored in the header of the binary outline store
+typedef struct {
+    int binary_version; // The version number of the code which produced this binary file
+    int outline_count; // The number of outlines in the store
+    unsigned long int file_points_start_position; // The position within file where the outline points start
+    dso_outline_info *outline_info; // Information about every outline
+} dso_outline_store_information;
+
+void dso_outlines_to_binary();
+
 void plot_deep_sky_outlines(chart_config *s, cairo_page *page);
 
 #endif
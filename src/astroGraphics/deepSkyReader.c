@@ -0,0 +1,415 @@
+// deepSkyReader.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+
+#include "astroGraphics/deepSkyReader.h"
+#include "coreUtils/asciiDouble.h"
+#include "coreUtils/errorReport.h"
+#include "mathsTools/projection.h"
+#include "mathsTools/sphericalTrig.h"
+#include "settings/chart_config.h"
+
+// Binary file format version number
+static const int dso_binary_format_version = 1;
+
+// Filenames
+const char *ascii_dso_catalogue = SRCDIR "../data/deepSky/ngcDistances/output/ngc_merged.txt";
+const char *binary_dso_catalogue = SRCDIR "../data/deepSky/ngcDistances/output/ngc_merged.bin";
+
+//! string_table - A growable buffer of null-terminated strings
+typedef struct {
+    char *data;
+    int length, capacity;
+} string_table;
+
+//! string_table_add - Add a string to a <string_table>
+//! \param table - The string table to add the string to
+//! \param str - The string to add
+//! \param deduplicate - Boolean flag indicating whether to reuse an identical string already in the table
+//! \return - The offset of the string within the table
+
+static int string_table_add(string_table *table, const char *str, int deduplicate) {
+    const int str_length = (int) strlen(str) + 1;
+
+    // Search for an existing copy of this string
+    if (deduplicate) {
+        for (int offset = 0; offset < table->length; offset += (int) strlen(table->data + offset) + 1) {
+            if (strcmp(table->data + offset, str) == 0) return offset;
+        }
+    }
+
+    // Grow the table if required
+    if (table->length + str_length > table->capacity) {
+        table->capacity = 2 * (table->length + str_length) + 1024;
+        table->data = realloc(table->data, table->capacity);
+        if (table->data == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+
+    const int offset = table->length;
+    memcpy(table->data + offset, str, str_length);
+    table->length += str_length;
+    return offset;
+}
+
+//! compare_dso_brightness - Sort deep sky objects into order of brightness, preserving catalogue order for objects
+//! of equal magnitude
+//! \param a - The first <dso_definition>
+//! \param b - The second <dso_definition>
+//! \return - qsort comparison result
+
+static int compare_dso_brightness(const void *a, const void *b) {
+    const dso_definition *da = (const dso_definition *) a;
+    const dso_definition *db = (const dso_definition *) b;
+    if (da->mag < db->mag) return -1;
+    if (da->mag > db->mag) return 1;
+    return da->catalogue_index - db->catalogue_index;
+}
+
+//! dso_tile_index - Calculate which tile a deep sky object should be put into
+//! \param ra - The right ascension of the object (radians)
+//! \param dec - The declination of the object (radians)
+//! \return - Integer offset within the <tile_info> array
+
+static int dso_tile_index(double ra, double dec) {
+    int ra_bin = (int) floor((ra / (2 * M_PI)) * DSO_TILE_RA_BINS);
+    int dec_bin = (int) floor(((dec / M_PI) + 0.5) * DSO_TILE_DEC_BINS);
+    ra_bin = (int) gsl_max(0, gsl_min(DSO_TILE_RA_BINS - 1, ra_bin));
+    dec_bin = (int) gsl_max(0, gsl_min(DSO_TILE_DEC_BINS - 1, dec_bin));
+    return dec_bin * DSO_TILE_RA_BINS + ra_bin;
+}
+
+//! dso_tile_in_field_of_view - Test whether a tile of the deep sky catalogue may contain objects within the field of
+//! view of a chart. We compare a cap on the sky which encloses the tile against a cap which encloses the field of
+//! view, which is conservative, so that no tile which overlaps the field of view is ever rejected.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param catalogue - The header information read from the binary deep sky catalogue
+//! \param ra_index - The RA index of the tile
+//! \param dec_index - The Dec index of the tile
+//! \return - Boolean flag indicating whether we need to read objects from within this tile
+
+static int dso_tile_in_field_of_view(chart_config *s, const dso_catalogue_information *catalogue, int ra_index,
+                                     int dec_index) {
+    // Objects are stored in RA/Dec, so we can only compare them against the field of view if the chart is centred in
+    // the same coordinates
+    const double field_radius = (s->coords == SW_COORDS_GAL) ? M_PI : field_of_view_radius(s);
+    if (field_radius >= M_PI) return 1;
+
+    // Work out the extent of this tile
+    const double ra_half_width = M_PI / catalogue->ra_bins;
+    const double dec_half_width = M_PI / 2 / catalogue->dec_bins;
+    const double ra_centre = (ra_index + 0.5) * (2 * M_PI) / catalogue->ra_bins;
+    const double dec_centre = ((dec_index + 0.5) / catalogue->dec_bins - 0.5) * M_PI;
+
+    // Any point in the tile can be reached from its centre by moving along a meridian to the right declination, and
+    // then along a parallel, which is never shorter than the great circle between them. The parallels are longest
+    // at the declination within the tile which is closest to the equator.
+    const double dec_closest_to_equator = gsl_max(0, fabs(dec_centre) - dec_half_width);
+    const double tile_radius = dec_half_width + ra_half_width * cos(dec_closest_to_equator);
+
+    const double distance = angDist_RADec(ra_centre, dec_centre, s->ra0, s->dec0);
+    return distance <= field_radius + tile_radius;
+}
+
+//! open_binary_dso_catalogue - Open the binary catalogue listing all the deep sky objects (for reading), creating it
+//! from the ASCII catalogue if it does not exist
+//! \return - File handle
+FILE *open_binary_dso_catalogue() {
+    FILE *file = fopen(binary_dso_catalogue, "r");
+
+    // If binary file was opened, check the version number is correct
+    if (file != NULL) {
+        int version_number;
+        if ((fread(&version_number, sizeof(int), 1, file) != 1) || (version_number != dso_binary_format_version)) {
+            fclose(file);
+            file = NULL;
+        }
+    }
+
+    // If binary file did not open successfully, recreate it from the ASCII catalogue
+    if (file == NULL) {
+        dso_list_to_binary();
+        file = fopen(binary_dso_catalogue, "r");
+        if (file == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary deep sky catalogue for reading");
+    }
+
+    // Return to the beginning of the file
+    fseek(file, 0, SEEK_SET);
+    return file;
+}
+
+//! read_binary_dso_catalogue_headers - Read the header of the binary deep sky catalogue, and its string table
+//! \param file - File handle to read the header from
+//! \return - A <dso_catalogue_information> structure
+dso_catalogue_information read_binary_dso_catalogue_headers(FILE *file) {
+    // Read from the beginning of the file
+    fseek(file, 0, SEEK_SET);
+
+    dso_catalogue_information catalogue;
+    fread(&catalogue.binary_version, sizeof(int), 1, file);
+    fread(&catalogue.ra_bins, sizeof(int), 1, file);
+    fread(&catalogue.dec_bins, sizeof(int), 1, file);
+    fread(&catalogue.total_dso_count, sizeof(int), 1, file);
+    fread(&catalogue.string_table_length, sizeof(int), 1, file);
+    fread(&catalogue.file_dsos_start_position, sizeof(unsigned long int), 1, file);
+    fread(&catalogue.file_strings_start_position, sizeof(unsigned long int), 1, file);
+
+    // Read data structure describing where to find individual tiles in this data file
+    const int tile_count = catalogue.ra_bins * catalogue.dec_bins;
+    catalogue.tile_info = malloc(tile_count * sizeof(dso_tile_info));
+    catalogue.string_table = malloc(catalogue.string_table_length + 1);
+    if ((catalogue.tile_info == NULL) || (catalogue.string_table == NULL)) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+    fread(catalogue.tile_info, tile_count * sizeof(dso_tile_info), 1, file);
+
+    // Read the string table of object names and types
+    fseek(file, (long) catalogue.file_strings_start_position, SEEK_SET);
+    fread(catalogue.string_table, catalogue.string_table_length, 1, file);
+    catalogue.string_table[catalogue.string_table_length] = '\0';
+    return catalogue;
+}
+
+//! write_binary_dso_catalogue_headers - Write the header of the binary deep sky catalogue
+//! \param catalogue - A <dso_catalogue_information> structure to write out
+//! \param out - File handle to write the headers to
+static void write_binary_dso_catalogue_headers(const dso_catalogue_information *catalogue, FILE *out) {
+    // Write to the beginning of the file
+    fseek(out, 0, SEEK_SET);
+
+    fwrite(&catalogue->binary_version, sizeof(int), 1, out);
+    fwrite(&catalogue->ra_bins, sizeof(int), 1, out);
+    fwrite(&catalogue->dec_bins, sizeof(int), 1, out);
+    fwrite(&catalogue->total_dso_count, sizeof(int), 1, out);
+    fwrite(&catalogue->string_table_length, sizeof(int), 1, out);
+    fwrite(&catalogue->file_dsos_start_position, sizeof(unsigned long int), 1, out);
+    fwrite(&catalogue->file_strings_start_position, sizeof(unsigned long int), 1, out);
+    fwrite(catalogue->tile_info, catalogue->ra_bins * catalogue->dec_bins * sizeof(dso_tile_info), 1, out);
+}
+
+//! free_binary_dso_catalogue_headers - Free up the storage used by a <dso_catalogue_information> structure
+//! \param catalogue - A <dso_catalogue_information> structure to free
+void free_binary_dso_catalogue_headers(dso_catalogue_information *catalogue) {
+    if (catalogue->tile_info != NULL) {
+        free(catalogue->tile_info);
+        catalogue->tile_info = NULL;
+    }
+    if (catalogue->string_table != NULL) {
+        free(catalogue->string_table);
+        catalogue->string_table = NULL;
+    }
+}
+
+//! read_dsos_in_field_of_view - Read all the deep sky objects which are bright enough to be shown, from the tiles of
+//! the binary catalogue which fall within the field of view of a chart. Objects are returned in order of brightness.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param file - File handle for the binary deep sky catalogue
+//! \param catalogue - The header information read from the binary deep sky catalogue
+//! \param [out] dso_count - The number of objects returned
+//! \return - Array of <dso_definition> structures, which should be freed by the caller
+dso_definition *read_dsos_in_field_of_view(chart_config *s, FILE *file, const dso_catalogue_information *catalogue,
+                                           int *dso_count) {
+    int capacity = 1024;
+    dso_definition *output = malloc(capacity * sizeof(dso_definition));
+    if (output == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    *dso_count = 0;
+
+    // Loop over Dec tiles
+    for (int dec_index = 0; dec_index < catalogue->dec_bins; dec_index++)
+        // Loop over RA tiles
+        for (int ra_index = 0; ra_index < catalogue->ra_bins; ra_index++) {
+            // Does this tile's sky area fall within field of view?
+            if (!dso_tile_in_field_of_view(s, catalogue, ra_index, dec_index)) continue;
+
+            // Seek to the position of this tile in the binary file
+            const dso_tile_info *tile = &catalogue->tile_info[dec_index * catalogue->ra_bins + ra_index];
+            const unsigned long int tile_file_pos = (catalogue->file_dsos_start_position +
+                                                     tile->file_position * sizeof(dso_definition));
+            fseek(file, (long) tile_file_pos, SEEK_SET);
+
+            // Loop over each object in turn
+            for (int i = 0; i < tile->dso_count; i++) {
+                dso_definition dso;
+                if (fread(&dso, sizeof(dso_definition), 1, file) != 1) break;
+
+                // Objects are sorted in order of brightness, so we can stop once they are too faint. Include
+                // objects with no magnitudes given if mag cutoff > mag 50.
+                if ((s->dso_mag_min < 50) && (s->dso_mag_min < dso.mag)) break;
+
+                if (*dso_count >= capacity) {
+                    capacity *= 2;
+                    output = realloc(output, capacity * sizeof(dso_definition));
+                    if (output == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+                }
+                output[(*dso_count)++] = dso;
+            }
+        }
+
+    // Merge the objects from all the tiles into a single list in order of brightness
+    qsort(output, *dso_count, sizeof(dso_definition), compare_dso_brightness);
+    return output;
+}
+
+//! dso_list_to_binary - Take the text-based list of deep sky objects in <ngc_merged.txt> and turn it into a binary
+//! tiled catalogue in <ngc_merged.bin>. This means we can read it much faster next time.
+void dso_list_to_binary() {
+    string_table strings = {NULL, 0, 0};
+    int dso_count = 0, capacity = 16384;
+    dso_definition *dsos = malloc(capacity * sizeof(dso_definition));
+    if (dsos == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+    // Open data file listing the positions of the NGC and IC objects
+    FILE *in = fopen(ascii_dso_catalogue, "r");
+    if (in == NULL) stch_fatal(__FILE__, __LINE__, "Could not open deep sky catalogue");
+
+    // Loop over the lines of the data file
+    while ((!feof(in)) && (!ferror(in))) {
+        char line[FNAME_LENGTH];
+        const char *line_ptr = line;
+
+        file_readline(in, line);
+
+        // Ignore comment lines
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\0')) continue;
+
+        // Extract data from line of text
+        dso_definition dso;
+        memset((void *) &dso, 0, sizeof(dso_definition)); // Ensures md5 checksum is the same on each run
+        while (*line_ptr == ' ') line_ptr++;
+        dso.messier_num = (int) get_float(line_ptr, NULL);
+        line_ptr = next_word(line_ptr);
+        dso.ngc_num = (int) get_float(line_ptr, NULL);
+        line_ptr = next_word(line_ptr);
+        dso.ic_num = (int) get_float(line_ptr, NULL);
+        line_ptr = next_word(line_ptr);
+        dso.ra = get_float(line_ptr, NULL) * M_PI / 12; // hours; J2000
+        line_ptr = next_word(line_ptr);
+        dso.dec = get_float(line_ptr, NULL) * M_PI / 180; // degrees; J2000
+        line_ptr = next_word(line_ptr);
+        dso.mag = get_float(line_ptr, NULL); // magnitude
+        line_ptr = next_word(line_ptr);
+        dso.axis_major = get_float(line_ptr, NULL); // arcminutes
+        line_ptr = next_word(line_ptr);
+        dso.axis_minor = get_float(line_ptr, NULL); // arcminutes
+        line_ptr = next_word(line_ptr);
+        dso.axis_pa = get_float(line_ptr, NULL); // position angle; degrees
+        line_ptr = next_word(line_ptr);
+        dso.catalogue_index = dso_count;
+
+        // Store the type of this object, e.g. "Gx" or "OC"
+        char type_string[FNAME_LENGTH];
+        get_word(type_string, line_ptr, FNAME_LENGTH);
+        dso.type_offset = string_table_add(&strings, type_string, 1);
+
+        // Create a name for this object
+        char object_name[FNAME_LENGTH] = "";
+        if (dso.messier_num > 0) {
+            snprintf(object_name, FNAME_LENGTH, "M%d", dso.messier_num);
+        } else if (dso.ngc_num > 0) {
+            snprintf(object_name, FNAME_LENGTH, "NGC%d", dso.ngc_num);
+        } else if (dso.ic_num > 0) {
+            snprintf(object_name, FNAME_LENGTH, "IC%d", dso.ic_num);
+        }
+        dso.name_offset = string_table_add(&strings, object_name, 0);
+
+        if (dso_count >= capacity) {
+            capacity *= 2;
+            dsos = realloc(dsos, capacity * sizeof(dso_definition));
+            if (dsos == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+        }
+        dsos[dso_count++] = dso;
+    }
+    fclose(in);
+
+    // Sort objects into tiles, and by brightness within each tile
+    int *tile_indices = malloc(dso_count * sizeof(int));
+    dso_catalogue_information catalogue;
+    catalogue.binary_version = dso_binary_format_version;
+    catalogue.ra_bins = DSO_TILE_RA_BINS;
+    catalogue.dec_bins = DSO_TILE_DEC_BINS;
+    catalogue.total_dso_count = dso_count;
+    catalogue.string_table_length = strings.length;
+    catalogue.tile_info = malloc(DSO_TILE_RA_BINS * DSO_TILE_DEC_BINS * sizeof(dso_tile_info));
+    catalogue.string_table = NULL;
+    if ((tile_indices == NULL) || (catalogue.tile_info == NULL)) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+    for (int i = 0; i < DSO_TILE_RA_BINS * DSO_TILE_DEC_BINS; i++) {
+        catalogue.tile_info[i].dso_count = 0;
+        catalogue.tile_info[i].file_position = 0;
+    }
+    qsort(dsos, dso_count, sizeof(dso_definition), compare_dso_brightness);
+    for (int i = 0; i < dso_count; i++) {
+        tile_indices[i] = dso_tile_index(dsos[i].ra, dsos[i].dec);
+        catalogue.tile_info[tile_indices[i]].dso_count++;
+    }
+
+    // Now work out the position within the file where each tile will get written
+    int total_dso_count = 0;
+    for (int i = 0; i < DSO_TILE_RA_BINS * DSO_TILE_DEC_BINS; i++) {
+        catalogue.tile_info[i].file_position = total_dso_count;
+        total_dso_count += catalogue.tile_info[i].dso_count;
+    }
+
+    // Start writing binary output file
+    FILE *out = fopen(binary_dso_catalogue, "wb");
+    if (out == NULL) stch_fatal(__FILE__, __LINE__, "Could not open binary deep sky catalogue for output");
+
+    // Write the header to find out where the object descriptors start, and then rewrite it with positions set
+    catalogue.file_dsos_start_position = 0;
+    catalogue.file_strings_start_position = 0;
+    write_binary_dso_catalogue_headers(&catalogue, out);
+    catalogue.file_dsos_start_position = ftell(out);
+    catalogue.file_strings_start_position = (catalogue.file_dsos_start_position +
+                                             dso_count * sizeof(dso_definition));
+    write_binary_dso_catalogue_headers(&catalogue, out);
+
+    // Write each object into its tile, keeping them in order of brightness
+    int *dsos_written = calloc(DSO_TILE_RA_BINS * DSO_TILE_DEC_BINS, sizeof(int));
+    if (dsos_written == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    for (int i = 0; i < dso_count; i++) {
+        const int tile = tile_indices[i];
+        const unsigned long int file_position = (catalogue.file_dsos_start_position +
+                                                 (catalogue.tile_info[tile].file_position + dsos_written[tile]) *
+                                                 sizeof(dso_definition));
+        fseek(out, (long) file_position, SEEK_SET);
+        fwrite(&dsos[i], sizeof(dso_definition), 1, out);
+        dsos_written[tile]++;
+    }
+
+    // Write the string table
+    fseek(out, (long) catalogue.file_strings_start_position, SEEK_SET);
+    if (strings.length > 0) fwrite(strings.data, strings.length, 1, out);
+
+    // Close output binary data file
+    fclose(out);
+
+    // Free up the temporary arrays we used
+    free_binary_dso_catalogue_headers(&catalogue);
+    free(dsos_written);
+    free(tile_indices);
+    free(dsos);
+    free(strings.data);
+}
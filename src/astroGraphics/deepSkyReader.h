@@ -0,0 +1,83 @@
+// deepSkyReader.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef DEEP_SKY_READER_H
+#define DEEP_SKY_READER_H 1
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "settings/chart_config.h"
+
+//! The number of cells into which the RA axis is divided when tiling the deep sky catalogue
+#define DSO_TILE_RA_BINS 24
+
+//! The number of cells into which the Dec axis is divided when tiling the deep sky catalogue
+#define DSO_TILE_DEC_BINS 12
+
+//! dso_definition - A structure to represent all of the data that describes a deep sky object
+typedef struct {
+    int messier_num, ngc_num, ic_num; // Catalogue numbers for this object; 0 for null
+    int catalogue_index; // The position of this object within the ASCII catalogue, used to order objects of equal mag
+    int name_offset; // The offset of this object's name within the string table
+    int type_offset; // The offset of this object's type (e.g. "Gx" or "OC") within the string table
+    double ra; // radians, J2000.0
+    double dec; // radians, J2000.0
+    double mag;
+    double axis_major, axis_minor; // arcminutes
+    double axis_pa; // position angle; degrees
+} dso_definition;
+
+//! dso_tile_info - A structure to hold information about where a tile of deep sky objects is to be found in the file
+typedef struct {
+    // The number of objects in this tile
+    int dso_count;
+
+    // The location in the binary file where the object descriptors in this tile start
+    // Stored in units of sizeof(dso_definition) beyond the start point of <file_dsos_start_position> bytes
+    int file_position;
+} dso_tile_info;
+
+//! dso_catalogue_information - Information stored in the header of a binary file containing a tiled DSO catalogue
+typedef struct {
+    int binary_version; // The version number of the code which produced this binary file
+    int ra_bins, dec_bins; // The number of cells into which the RA and Dec axes are divided
+    int total_dso_count; // The total number of objects in the catalogue
+    int string_table_length; // The number of bytes in the string table of object names and types
+    unsigned long int file_dsos_start_position; // The position within file where object descriptors start
+    unsigned long int file_strings_start_position; // The position within file where the string table starts
+    dso_tile_info *tile_info; // Information about every tile
+    char *string_table; // Null-terminated strings, referenced by <name_offset> and <type_offset>
+} dso_catalogue_information;
+
+extern const char *ascii_dso_catalogue; // The filename for the ascii deep sky catalogue
+extern const char *binary_dso_catalogue; // The filename for the binary tiled deep sky catalogue
+
+FILE *open_binary_dso_catalogue();
+dso_catalogue_information read_binary_dso_catalogue_headers(FILE *file);
+void free_binary_dso_catalogue_headers(dso_catalogue_information *catalogue);
+
+dso_definition *read_dsos_in_field_of_view(chart_config *s, FILE *file, const dso_catalogue_information *catalogue,
+                                           int *dso_count);
+
+void dso_list_to_binary();
+
+#endif
@@ -24,11 +24,15 @@
 #include <string.h>
 #include <math.h>
 
+#include <sys/stat.h>
+
 #include <gsl/gsl_math.h>
 
 #include "astroGraphics/ephemeris.h"
+#include "astroGraphics/ephemerisCache.h"
 #include "coreUtils/asciiDouble.h"
 #include "coreUtils/errorReport.h"
+#include "mathsTools/ephemerisEngine.h"
 #include "mathsTools/julianDate.h"
 #include "mathsTools/projection.h"
 #include "mathsTools/sphericalTrig.h"
@@ -36,147 +40,225 @@
 #include "vectorGraphics/lineDraw.h"
 #include "vectorGraphics/cairo_page.h"
 
+//! ephemeris_record_point - Store a data point into an ephemeris, and keep track of the extreme values of its
+//! brightness, phase and angular size
+//! \param e - The ephemeris to store the data point in
+//! \param index - The position within the ephemeris to store the data point at
+//! \param point - The data point to store
+
+static void ephemeris_record_point(ephemeris *e, int index, const ephemeris_point *point) {
+    e->data[index] = *point;
+    e->data[index].text_label = NULL;
+    e->data[index].sub_month_label = 0;
+
+    // Keep track of maximum values
+    if (point->mag < e->brightest_magnitude) e->brightest_magnitude = point->mag;
+    if (point->phase < e->minimum_phase) e->minimum_phase = point->phase;
+    if (point->angular_size > e->maximum_angular_size) e->maximum_angular_size = point->angular_size;
+}
+
+//! ephemeris_compute_builtin - Compute the ephemeris of a solar system object using the built-in ephemeris engine
+//! \param e - The ephemeris to populate. The fields <jd_start>, <jd_end> and <jd_step> must already be set.
+//! \param body - The body to compute, as returned by <ephemeris_engine_body_from_name>
+
+static void ephemeris_compute_builtin(ephemeris *e, int body) {
+    // Allocate data to hold the ephemeris, including both end points
+    const int step_count = (int) floor((e->jd_end - e->jd_start) / e->jd_step + 1e-9);
+    e->point_count = gsl_max(0, step_count) + 1;
+    e->data = (ephemeris_point *) malloc(e->point_count * sizeof(ephemeris_point));
+    if (e->data == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+    for (int j = 0; j < e->point_count; j++) {
+        ephemeris_point point;
+        ephemeris_engine_compute(body, e->jd_start + j * e->jd_step, &point);
+        ephemeris_record_point(e, j, &point);
+    }
+}
+
+//! ephemeris_compute_external - Compute the ephemeris of a solar system object by running the external tool
+//! ephemerisCompute. Results are stored in the ephemeris cache, so that they can be reused without running the tool
+//! again.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param e - The ephemeris to populate. The fields <jd_start>, <jd_end> and <jd_step> must already be set.
+//! \param object_id - The name of the object, as passed to ephemerisCompute
+
+static void ephemeris_compute_external(chart_config *s, ephemeris *e, const char *object_id) {
+    // Construct the key used to look this ephemeris up in the cache. This includes the modification time and size of
+    // the ephemerisCompute binary, so that cached results are discarded if the tool is updated.
+    char cache_key[FNAME_LENGTH];
+    struct stat tool_status;
+    if (stat(s->ephemeris_compute_path, &tool_status) != 0) memset(&tool_status, 0, sizeof(tool_status));
+    snprintf(cache_key, FNAME_LENGTH, "%.256s|%.15f|%.15f|%.15f|%.2048s|%lld|%lld",
+             object_id, e->jd_start, e->jd_end, e->jd_step, s->ephemeris_compute_path,
+             (long long) tool_status.st_mtime, (long long) tool_status.st_size);
+
+    // If this ephemeris is in the cache, there is no need to run ephemerisCompute
+    int cached_point_count = 0;
+    ephemeris_point *cached_points = ephemeris_cache_read(s->ephemeris_cache_dir, cache_key, &cached_point_count);
+    if (cached_points != NULL) {
+        e->data = cached_points;
+        e->point_count = cached_point_count;
+        for (int j = 0; j < e->point_count; j++) {
+            const ephemeris_point point = cached_points[j];
+            ephemeris_record_point(e, j, &point);
+        }
+        return;
+    }
+
+    // Allocate data to hold the ephemeris, starting with a generous estimate of how many lines we expect
+    // ephemerisCompute to return. This buffer is expanded if more lines are returned.
+    int buffer_length = (int) (20 + (e->jd_end - e->jd_start) / e->jd_step);
+    e->data = (ephemeris_point *) malloc(buffer_length * sizeof(ephemeris_point));
+    if (e->data == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+    // Use ephemeris-compute-de430 to track the path of this object
+    char ephemeris_compute_command[FNAME_LENGTH];
+
+    // Construct a command-line to run the ephemeris generation tool
+    snprintf(ephemeris_compute_command, FNAME_LENGTH, "%.2048s "
+                                                      "--jd_min %.15f "
+                                                      "--jd_max %.15f "
+                                                      "--jd_step %.15f "
+                                                      "--output_format 2 "
+                                                      "--output_constellations 0 "
+                                                      "--output_binary 0 "
+                                                      "--objects \"%.256s\" ",
+             s->ephemeris_compute_path, e->jd_start, e->jd_end, e->jd_step, object_id);
+
+    // Run ephemeris generator
+    FILE *ephemeris_data = popen(ephemeris_compute_command, "r");
+    // printf("%s\n", ephemeris_compute_command);
+    if (ephemeris_data == NULL) stch_fatal(__FILE__, __LINE__, "Could not run ephemeris-compute-de430");
+
+    // Loop over the lines returned by ephemeris-compute-de430
+    int line_counter = 0;
+    while ((!feof(ephemeris_data)) && (!ferror(ephemeris_data))) {
+        char line[FNAME_LENGTH];
+
+        // Read line of output text
+        file_readline(ephemeris_data, line);
+        // printf("%s\n", line);
+
+        // Filter whitespace from the beginning of the line
+        const char *scan = line;
+        while ((*scan > '\0') && (*scan <= ' ')) scan++;
+
+        // Ignore blank lines
+        if (scan[0] == '\0') continue;
+
+        // Ignore comment lines
+        if (scan[0] == '#') continue;
+
+        // Read columns of data output from the ephemeris generator
+        ephemeris_point point;
+        point.jd = get_float(scan, NULL); // Julian day number
+        scan = next_word(scan);
+        scan = next_word(scan);
+        scan = next_word(scan);
+        scan = next_word(scan);
+        point.ra = get_float(scan, NULL); // radians
+        scan = next_word(scan);
+        point.dec = get_float(scan, NULL); // radians
+        scan = next_word(scan);
+        point.mag = get_float(scan, NULL);
+        scan = next_word(scan);
+        point.phase = get_float(scan, NULL); // 0-1
+        scan = next_word(scan);
+        point.angular_size = get_float(scan, NULL); // arcseconds
+
+        // Expand the buffer if it is full
+        if (line_counter >= buffer_length) {
+            buffer_length *= 2;
+            e->data = (ephemeris_point *) realloc(e->data, buffer_length * sizeof(ephemeris_point));
+            if (e->data == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+        }
+
+        // Store this data point into the ephemeris
+        ephemeris_record_point(e, line_counter, &point);
+
+        // Increment data point counter
+        line_counter++;
+    }
+    pclose(ephemeris_data);
+
+    // Throw an error if we got no data
+    if (line_counter == 0) {
+        stch_fatal(__FILE__, __LINE__, "ephemeris-compute-de430 returned no data");
+        exit(1);
+    }
+
+    // Record how many lines of data were returned from ephemeris-compute-de430
+    e->point_count = line_counter;
+
+    // Store this ephemeris in the cache
+    ephemeris_cache_write(s->ephemeris_cache_dir, cache_key, e->data, e->point_count);
+}
+
 //! ephemerides_fetch - Fetch the ephemeris data for solar system objects to be plotted on a star chart
 //! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
 
 void ephemerides_fetch(chart_config *s) {
     int i;
     int total_ephemeris_points = 0;
+    int body[N_TRACES_MAX];
+    char object_id[N_TRACES_MAX][FNAME_LENGTH];
 
     // Allocate storage for the ephemeris of each solar system object
     s->ephemeris_data = (ephemeris *) malloc(s->ephemeride_count * sizeof(ephemeris));
 
     // Loop over each of the solar system objects we are plotting tracks for
     for (i = 0; i < s->ephemeride_count; i++) {
+        ephemeris *e = &s->ephemeris_data[i];
+
         // Fetch the string definition, passed by the user
         // For example: jupiter,2458849.5,2459216.5
         const char *trace_definition = s->ephemeris_definitions[i];
 
         // Extract object name, jd_min and jd_max from trace definition string
         const char *in_scan = trace_definition;
-        char object_id[FNAME_LENGTH], buffer[FNAME_LENGTH];
+        char buffer[FNAME_LENGTH];
         // Read object name into <object_id>
-        str_comma_separated_list_scan(&in_scan, object_id);
-        // Read starting Julian day number into s->ephemeris_data[i].jd_start
+        str_comma_separated_list_scan(&in_scan, object_id[i]);
+        // Read starting Julian day number into e->jd_start
         str_comma_separated_list_scan(&in_scan, buffer);
-        s->ephemeris_data[i].jd_start = get_float(buffer, NULL);
-        // Read ending Julian day number into s->ephemeris_data[i].jd_end
+        e->jd_start = get_float(buffer, NULL);
+        // Read ending Julian day number into e->jd_end
         str_comma_separated_list_scan(&in_scan, buffer);
-        s->ephemeris_data[i].jd_end = get_float(buffer, NULL);
+        e->jd_end = get_float(buffer, NULL);
         // Sample planet's movement every 12 hours
-        s->ephemeris_data[i].jd_step = 0.5;
-
-        const double ephemeris_duration = s->ephemeris_data[i].jd_end - s->ephemeris_data[i].jd_start; // days
-
-        // Generous estimate of how many lines we expect ephemerisCompute to return
-        s->ephemeris_data[i].point_count = (int) (20 +
-                                                  ephemeris_duration / s->ephemeris_data[i].jd_step
-        );
+        e->jd_step = 0.5;
 
         // Keep track of the brightest magnitude and largest angular size of the object
-        s->ephemeris_data[i].brightest_magnitude = 999;
-        s->ephemeris_data[i].minimum_phase = 1;
-        s->ephemeris_data[i].maximum_angular_size = 0;
-
-        // Allocate data to hold the ephemeris
-        s->ephemeris_data[i].data = (ephemeris_point *) malloc(
-                s->ephemeris_data[i].point_count * sizeof(ephemeris_point)
-        );
-
-        // Use ephemeris-compute-de430 to track the path of this object
-        char ephemeris_compute_command[FNAME_LENGTH];
-
-        // Construct a command-line to run the ephemeris generation tool
-        snprintf(ephemeris_compute_command, FNAME_LENGTH, "%.2048s "
-                                                          "--jd_min %.15f "
-                                                          "--jd_max %.15f "
-                                                          "--jd_step %.15f "
-                                                          "--output_format 2 "
-                                                          "--output_constellations 0 "
-                                                          "--output_binary 0 "
-                                                          "--objects \"%.256s\" ",
-                 s->ephemeris_compute_path,
-                 s->ephemeris_data[i].jd_start, s->ephemeris_data[i].jd_end, s->ephemeris_data[i].jd_step, object_id);
-
-        // Run ephemeris generator
-        FILE *ephemeris_data = popen(ephemeris_compute_command, "r");
-        // printf("%s\n", ephemeris_compute_command);
-
-        // Loop over the lines returned by ephemeris-compute-de430
-        int line_counter = 0;
-        while ((!feof(ephemeris_data)) && (!ferror(ephemeris_data))) {
-            char line[FNAME_LENGTH];
-
-            // Read line of output text
-            file_readline(ephemeris_data, line);
-            // printf("%s\n", line);
-
-            // Filter whitespace from the beginning of the line
-            const char *scan = line;
-            while ((*scan > '\0') && (*scan <= ' ')) scan++;
-
-            // Ignore blank lines
-            if (scan[0] == '\0') continue;
-
-            // Ignore comment lines
-            if (scan[0] == '#') continue;
-
-            // Read columns of data output from the ephemeris generator
-            double jd = get_float(scan, NULL); // Julian day number
-            scan = next_word(scan);
-            scan = next_word(scan);
-            scan = next_word(scan);
-            scan = next_word(scan);
-            double ra = get_float(scan, NULL); // radians
-            scan = next_word(scan);
-            double dec = get_float(scan, NULL); // radians
-            scan = next_word(scan);
-            double magnitude = get_float(scan, NULL);
-            scan = next_word(scan);
-            double phase = get_float(scan, NULL); // 0-1
-            scan = next_word(scan);
-            double angular_size = get_float(scan, NULL); // arcseconds
-
-            // Store this data point into s->ephemeris_data
-            s->ephemeris_data[i].data[line_counter].jd = jd;
-            s->ephemeris_data[i].data[line_counter].ra = ra;
-            s->ephemeris_data[i].data[line_counter].dec = dec;
-            s->ephemeris_data[i].data[line_counter].mag = magnitude;
-            s->ephemeris_data[i].data[line_counter].phase = phase;
-            s->ephemeris_data[i].data[line_counter].angular_size = angular_size;
-            s->ephemeris_data[i].data[line_counter].text_label = NULL;
-            s->ephemeris_data[i].data[line_counter].sub_month_label = 0;
-
-            // Keep track of maximum values
-            if (magnitude < s->ephemeris_data[i].brightest_magnitude) {
-                s->ephemeris_data[i].brightest_magnitude = magnitude;
-            }
-
-            if (phase < s->ephemeris_data[i].minimum_phase) {
-                s->ephemeris_data[i].minimum_phase = phase;
-            }
-
-            if (angular_size > s->ephemeris_data[i].maximum_angular_size) {
-                s->ephemeris_data[i].maximum_angular_size = angular_size;
-            }
-
-            // Increment data point counter
-            line_counter++;
-        }
-
-        // Throw an error if we got no data
-        if (line_counter == 0) {
-            stch_fatal(__FILE__, __LINE__, "ephemeris-compute-de430 returned no data");
-            exit(1);
+        e->brightest_magnitude = 999;
+        e->minimum_phase = 1;
+        e->maximum_angular_size = 0;
+
+        // The track drawn on the chart is sampled later, once the projection is known
+        e->track_point_count = 0;
+        e->track = NULL;
+
+        // Compute the ephemeris in-process if the built-in engine can compute this object over this period;
+        // otherwise fall back to running ephemerisCompute
+        body[i] = -1;
+        if (s->ephemeris_engine == SW_EPHEMERIS_BUILTIN) {
+            body[i] = ephemeris_engine_body_from_name(object_id[i], e->jd_start, e->jd_end);
         }
+        e->engine_body = body[i];
+    }
 
-        // Record how many lines of data were returned from ephemeris-compute-de430
-        s->ephemeris_data[i].point_count = line_counter;
-
-        // Keep tally of the sum total number of points on all ephemerides
-        total_ephemeris_points += s->ephemeris_data[i].point_count;
+    // Compute all the ephemerides concurrently, with one thread per object, since most of the time is spent
+    // waiting for ephemerisCompute
+    const int thread_count = (s->ephemeride_count > 0) ? s->ephemeride_count : 1;
+#pragma omp parallel for shared(s, body, object_id) private(i) schedule(dynamic) num_threads(thread_count)
+    for (i = 0; i < s->ephemeride_count; i++) {
+        ephemeris *e = &s->ephemeris_data[i];
+        if (body[i] >= 0) ephemeris_compute_builtin(e, body[i]);
+        else ephemeris_compute_external(s, e, object_id[i]);
     }
 
+    // Keep tally of the sum total number of points on all ephemerides
+    for (i = 0; i < s->ephemeride_count; i++) total_ephemeris_points += s->ephemeris_data[i].point_count;
+
     // Automatically scale plot to contain all the computed ephemeris tracks
     ephemerides_autoscale_plot(s, total_ephemeris_points);
 
@@ -192,6 +274,7 @@ void ephemerides_free(chart_config *s) {
     int i;
     for (i = 0; i < s->ephemeride_count; i++) {
         free(s->ephemeris_data[i].data);
+        free(s->ephemeris_data[i].track);
     }
     free(s->ephemeris_data);
 }
@@ -438,14 +521,18 @@ void ephemerides_add_text_labels(chart_config *s) {
         for (int line_counter = 0; line_counter < s->ephemeris_data[i].point_count; line_counter++) {
             const double jd = s->ephemeris_data[i].data[line_counter].jd;
 
-            // Work out angular speed of object, to decide how often to write labels
+            // Work out angular speed of object, to decide how often to write labels. We use the actual time
+            // interval between data points, since ephemerisCompute may not return points at exactly <jd_step>.
             double angular_speed = 1e6; // radians per day
             if (line_counter > 0) {
-                angular_speed = angDist_RADec(s->ephemeris_data[i].data[line_counter - 1].ra,
-                                              s->ephemeris_data[i].data[line_counter - 1].dec,
-                                              s->ephemeris_data[i].data[line_counter].ra,
-                                              s->ephemeris_data[i].data[line_counter].dec
-                ) / s->ephemeris_data[i].jd_step;
+                const double time_step = jd - s->ephemeris_data[i].data[line_counter - 1].jd;
+                if (time_step > 0) {
+                    angular_speed = angDist_RADec(s->ephemeris_data[i].data[line_counter - 1].ra,
+                                                  s->ephemeris_data[i].data[line_counter - 1].dec,
+                                                  s->ephemeris_data[i].data[line_counter].ra,
+                                                  s->ephemeris_data[i].data[line_counter].dec
+                    ) / time_step;
+                }
             }
 
             // Convert from radians/day to cm/day
@@ -505,6 +592,217 @@ void ephemerides_add_text_labels(chart_config *s) {
     }
 }
 
+//! ephemeris_track_sampler - The state of an ephemeris track which is being adaptively sampled
+typedef struct {
+    //! The star chart the track is to be drawn on
+    chart_config *s;
+
+    //! The ephemeris whose track we are sampling. Its <data> are the points originally fetched.
+    const ephemeris *e;
+
+    //! The greatest permitted distance between the track and the straight lines used to draw it, graph coordinates
+    double tolerance;
+
+    //! The shortest permitted time interval between points on the track, days
+    double minimum_interval;
+
+    //! The points we have selected to draw the track with, of which there is space for <buffer_length>
+    ephemeris_point *track;
+    int track_point_count;
+    int buffer_length;
+} ephemeris_track_sampler;
+
+//! ephemeris_track_evaluate - Find the position of a solar system object at an arbitrary time, for use when sampling
+//! its track. Objects handled by the built-in ephemeris engine are computed afresh. For objects computed by
+//! ephemerisCompute, we return the closest of the data points it returned.
+//! \param sampler - The ephemeris track which is being sampled
+//! \param jd - The Julian day number at which we want the object's position
+//! \param [out] output - The position of the object
+
+static void ephemeris_track_evaluate(const ephemeris_track_sampler *sampler, double jd, ephemeris_point *output) {
+    const ephemeris *e = sampler->e;
+
+    if (e->engine_body >= 0) {
+        ephemeris_engine_compute(e->engine_body, jd, output);
+        return;
+    }
+
+    // Binary search for the first data point at or after <jd>, then pick whichever neighbour is closer
+    int low = 0, high = e->point_count - 1;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (e->data[middle].jd < jd) low = middle + 1;
+        else high = middle;
+    }
+    if ((low > 0) && (jd - e->data[low - 1].jd < e->data[low].jd - jd)) low--;
+
+    *output = e->data[low];
+    output->text_label = NULL;
+    output->sub_month_label = 0;
+}
+
+//! ephemeris_track_append - Add a point to the end of an adaptively-sampled ephemeris track
+//! \param sampler - The ephemeris track which is being sampled
+//! \param point - The point to add to the track
+
+static void ephemeris_track_append(ephemeris_track_sampler *sampler, const ephemeris_point *point) {
+    // Expand the buffer if it is full
+    if (sampler->track_point_count >= sampler->buffer_length) {
+        sampler->buffer_length *= 2;
+        sampler->track = (ephemeris_point *) realloc(sampler->track, sampler->buffer_length * sizeof(ephemeris_point));
+        if (sampler->track == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+    }
+
+    sampler->track[sampler->track_point_count++] = *point;
+}
+
+//! ephemeris_track_needs_refinement - Decide whether the straight line between two points on an ephemeris track is
+//! an adequate representation of the track, by checking whether a point within the time interval lies close enough
+//! to it on the chart.
+//! \param sampler - The ephemeris track which is being sampled
+//! \param start - The point at the start of the interval
+//! \param middle - A point within the interval
+//! \param end - The point at the end of the interval
+//! \return - Boolean indicating whether the interval needs to be subdivided
+
+static int ephemeris_track_needs_refinement(const ephemeris_track_sampler *sampler, const ephemeris_point *start,
+                                            const ephemeris_point *middle, const ephemeris_point *end) {
+    chart_config *s = sampler->s;
+
+    // Never take long steps across the sky, in case we step over a loop in the object's path. On small charts, we
+    // also need to make sure we don't step right across the chart between two points which lie outside it.
+    const double maximum_step = gsl_min(EPHEMERIS_TRACK_MAX_STEP * M_PI / 180,
+                                        s->angular_width * gsl_min(1, s->aspect) / 4);
+    if (angDist_RADec(start->ra, start->dec, end->ra, end->dec) > maximum_step) return 1;
+
+    // Project all three points onto the chart
+    double x0, y0, x1, y1, x2, y2;
+    plane_project(&x0, &y0, s, start->ra, start->dec, 0);
+    plane_project(&x1, &y1, s, middle->ra, middle->dec, 0);
+    plane_project(&x2, &y2, s, end->ra, end->dec, 0);
+
+    // If the track passes onto the far side of the sky, where it cannot be projected, pin down where it does so
+    const int start_finite = gsl_finite(x0) && gsl_finite(y0);
+    const int end_finite = gsl_finite(x2) && gsl_finite(y2);
+    if (start_finite != end_finite) return 1;
+
+    // Otherwise, points which cannot be projected are not drawn, so their precise positions do not matter
+    if ((!start_finite) || (!end_finite) || (!gsl_finite(x1)) || (!gsl_finite(y1))) return 0;
+
+    // Work out the distance of the middle point from the line segment joining the two ends
+    const double dx = x2 - x0, dy = y2 - y0;
+    const double length_squared = gsl_pow_2(dx) + gsl_pow_2(dy);
+    double t = 0;
+    if (length_squared > 0) t = gsl_max(0, gsl_min(1, ((x1 - x0) * dx + (y1 - y0) * dy) / length_squared));
+    const double offset = hypot(x1 - (x0 + t * dx), y1 - (y0 + t * dy));
+
+    return offset > sampler->tolerance;
+}
+
+//! ephemeris_track_refine - Add points to an ephemeris track in the time interval between two points, recursively
+//! subdividing the interval until the track is drawn to within the required tolerance. The end points themselves
+//! are not added.
+//! \param sampler - The ephemeris track which is being sampled
+//! \param start - The point at the start of the interval
+//! \param end - The point at the end of the interval
+
+static void ephemeris_track_refine(ephemeris_track_sampler *sampler, const ephemeris_point *start,
+                                   const ephemeris_point *end) {
+    if (end->jd - start->jd < 2 * sampler->minimum_interval) return;
+
+    // Find the position of the object halfway through this interval
+    ephemeris_point middle;
+    ephemeris_track_evaluate(sampler, (start->jd + end->jd) / 2, &middle);
+
+    // If there are no data points between the two ends, we cannot subdivide the interval any further
+    if ((middle.jd <= start->jd) || (middle.jd >= end->jd)) return;
+
+    // Check the quarter points as well as the middle, since near a stationary point the middle of the interval may
+    // lie on the straight line even though the track turns back on itself
+    ephemeris_point quarter, three_quarters;
+    ephemeris_track_evaluate(sampler, (3 * start->jd + end->jd) / 4, &quarter);
+    ephemeris_track_evaluate(sampler, (start->jd + 3 * end->jd) / 4, &three_quarters);
+
+    if ((!ephemeris_track_needs_refinement(sampler, start, &middle, end)) &&
+        (!ephemeris_track_needs_refinement(sampler, start, &quarter, end)) &&
+        (!ephemeris_track_needs_refinement(sampler, start, &three_quarters, end)))
+        return;
+
+    ephemeris_track_refine(sampler, start, &middle);
+    ephemeris_track_append(sampler, &middle);
+    ephemeris_track_refine(sampler, &middle, end);
+}
+
+//! ephemerides_sample_tracks - Select the points used to draw each ephemeris track on the star chart. We start with
+//! only the end points of the track and the points with text labels, and then subdivide each interval wherever the
+//! projected track bends away from a straight line by more than <EPHEMERIS_TRACK_TOLERANCE> pixels. This means the
+//! number of points we draw depends on how complicated the track looks on the chart, rather than on its duration.
+//! This must be called after <config_init>, since it uses the chart's projection.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+
+void ephemerides_sample_tracks(chart_config *s) {
+    for (int i = 0; i < s->ephemeride_count; i++) {
+        ephemeris *e = &s->ephemeris_data[i];
+        ephemeris_track_sampler sampler;
+
+        sampler.s = s;
+        sampler.e = e;
+        sampler.tolerance = EPHEMERIS_TRACK_TOLERANCE * 2.54 / s->png_dpi * s->wlin / s->width;
+        sampler.minimum_interval = (e->engine_body >= 0) ? EPHEMERIS_TRACK_MIN_INTERVAL : 0;
+        sampler.buffer_length = 64;
+        sampler.track_point_count = 0;
+        sampler.track = (ephemeris_point *) malloc(sampler.buffer_length * sizeof(ephemeris_point));
+        if (sampler.track == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+        // Keep the end points of the track, and every point with a tick mark, and refine the intervals between them
+        int previous = 0;
+        for (int j = 0; j < e->point_count; j++) {
+            if ((j > 0) && (j < e->point_count - 1) && (e->data[j].text_label == NULL)) continue;
+            if (j > 0) ephemeris_track_refine(&sampler, &e->data[previous], &e->data[j]);
+            ephemeris_track_append(&sampler, &e->data[j]);
+            previous = j;
+        }
+
+        free(e->track);
+        e->track = sampler.track;
+        e->track_point_count = sampler.track_point_count;
+    }
+}
+
+//! ephemeris_clip_segment - Clip a straight line segment to the rectangular plot area of a star chart
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param [in,out] x0 - The x coordinate of the start of the segment (graph coordinates)
+//! \param [in,out] y0 - The y coordinate of the start of the segment (graph coordinates)
+//! \param [in,out] x1 - The x coordinate of the end of the segment (graph coordinates)
+//! \param [in,out] y1 - The y coordinate of the end of the segment (graph coordinates)
+//! \return - Boolean indicating whether any part of the segment lies within the plot area
+
+static int ephemeris_clip_segment(const chart_config *s, double *x0, double *y0, double *x1, double *y1) {
+    const double dx = *x1 - *x0, dy = *y1 - *y0;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {*x0 - s->x_min, s->x_max - *x0, *y0 - s->y_min, s->y_max - *y0};
+    double t0 = 0, t1 = 1;
+
+    // Liang-Barsky clipping against each of the four edges of the plot area in turn
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            if (q[i] < 0) return 0;
+        } else {
+            const double t = q[i] / p[i];
+            if (p[i] < 0) t0 = gsl_max(t0, t);
+            else t1 = gsl_min(t1, t);
+        }
+    }
+    if (t0 > t1) return 0;
+
+    const double x_start = *x0, y_start = *y0;
+    *x0 = x_start + t0 * dx;
+    *y0 = y_start + t0 * dy;
+    *x1 = x_start + t1 * dx;
+    *y1 = y_start + t1 * dy;
+    return 1;
+}
+
 //! plot_ephemeris - Plot an ephemeris for a solar system object.
 //! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
 //! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
@@ -520,14 +818,31 @@ void plot_ephemeris(chart_config *s, line_drawer *ld, cairo_page *page, int trac
     cairo_set_source_rgb(s->cairo_draw, s->ephemeris_col.red, s->ephemeris_col.grn, s->ephemeris_col.blu);
     ld_label(ld, NULL, 1, 1, 1);
 
-    // Loop over the points in the ephemeris, and draw a line across the star chart
+    // Loop over the points on the ephemeris track, and draw a line across the star chart
     const ephemeris *e = &s->ephemeris_data[trace_num];
-    for (i = 0; i < e->point_count; i++) {
+    const ephemeris_point *track = e->track;
+    for (i = 0; i < e->track_point_count; i++) {
         double x, y;
 
         // Work out the coordinates of each ephemeris data point on the plotting canvas
-        plane_project(&x, &y, s, e->data[i].ra, e->data[i].dec, 0);
-        if ((x < s->x_min) || (x > s->x_max) || (y < s->y_min) || (y > s->y_max)) continue;
+        plane_project(&x, &y, s, track[i].ra, track[i].dec, 0);
+
+        // Points on the far side of the sky break the line. Points which are merely off the edge of the chart are
+        // passed to the line drawer, which clips the line at the edge of the plot area.
+        if ((!gsl_finite(x)) || (!gsl_finite(y))) {
+            ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+            continue;
+        }
+
+        // On flat projections, a track which is off the edge of the chart may wrap around from one side of the sky
+        // to the other. The line drawer only deals with this when both points are on the chart.
+        const int on_chart = (x >= s->x_min) && (x <= s->x_max) && (y >= s->y_min) && (y <= s->y_max);
+        const int last_on_chart = (last_x >= s->x_min) && (last_x <= s->x_max) &&
+                                  (last_y >= s->y_min) && (last_y <= s->y_max);
+        if ((i > 0) && ((!on_chart) || (!last_on_chart)) && (fabs(x - last_x) > s->wlin / 2) &&
+            ((s->projection == SW_PROJECTION_FLAT) || (s->projection == SW_PROJECTION_PETERS))) {
+            ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
+        }
 
         // Add this point to the line we are tracing
         ld_point(ld, x, y, NULL);
@@ -544,18 +859,18 @@ void plot_ephemeris(chart_config *s, line_drawer *ld, cairo_page *page, int trac
     // Then draw tick marks to indicate notable points along the path of the object
     int is_first_label = 1;
 
-    for (i = 0; i < e->point_count; i++) {
+    for (i = 0; i < e->track_point_count; i++) {
         double x, y, theta;
 
         // Work out how long this tick mark should be; major time points get longer ticks
-        const double physical_tick_len = e->data[i].sub_month_label ? 0.12 : 0.2; // cm
-        const double line_width = e->data[i].sub_month_label ? 0.8 : 2;
+        const double physical_tick_len = track[i].sub_month_label ? 0.12 : 0.2; // cm
+        const double line_width = track[i].sub_month_label ? 0.8 : 2;
         const double graph_coords_tick_len = physical_tick_len * s->wlin / s->width;
 
         cairo_set_line_width(s->cairo_draw, line_width * s->line_width_base);
 
         // Work out coordinates of this tick mark on the plotting canvas
-        plane_project(&x, &y, s, e->data[i].ra, e->data[i].dec, 0);
+        plane_project(&x, &y, s, track[i].ra, track[i].dec, 0);
 
         // Work out direction of ephemeris track
         if (i < 2) theta = initial_theta;
@@ -564,18 +879,32 @@ void plot_ephemeris(chart_config *s, line_drawer *ld, cairo_page *page, int trac
         // This happens when ephemeris track is the same twice running; deal gracefully with it
         if (!gsl_finite(theta)) theta = 0.0;
 
+        // Add the track to the label exclusion region so that labels don't collide with it. Points on the track may
+        // be widely spaced where it is straight, so we fill in the line from the previous point, unless it wraps
+        // around the edge of the chart. We only fill in the part of the line which lies within the plot area.
+        const double exclusion_size = graph_coords_tick_len * 0.1;
+        double x_a = x, y_a = y, x_b = x, y_b = y;
+        if ((i > 0) && gsl_finite(last_x) && gsl_finite(last_y) && (fabs(x - last_x) < s->wlin / 2)) {
+            x_b = last_x;
+            y_b = last_y;
+        }
+        if (gsl_finite(x) && gsl_finite(y) && ephemeris_clip_segment(s, &x_a, &y_a, &x_b, &y_b)) {
+            int exclusion_count = (int) ceil(hypot(x_b - x_a, y_b - y_a) / (2 * exclusion_size));
+            if (exclusion_count < 1) exclusion_count = 1;
+            if (exclusion_count > EPHEMERIS_TRACK_MAX_EXCLUSIONS) exclusion_count = EPHEMERIS_TRACK_MAX_EXCLUSIONS;
+            for (int k = 0; k <= exclusion_count; k++) {
+                const double x_k = x_a + (x_b - x_a) * k / exclusion_count;
+                const double y_k = y_a + (y_b - y_a) * k / exclusion_count;
+                chart_add_label_exclusion(page, s, x_k - exclusion_size, x_k + exclusion_size,
+                                          y_k - exclusion_size, y_k + exclusion_size);
+            }
+        }
+
         last_x = x;
         last_y = y;
 
-        // Add point to label exclusion region so that labels don't collide with it
-        page->exclusion_regions[page->exclusion_region_counter].x_min = x - graph_coords_tick_len * 0.1;
-        page->exclusion_regions[page->exclusion_region_counter].x_max = x + graph_coords_tick_len * 0.1;
-        page->exclusion_regions[page->exclusion_region_counter].y_min = y - graph_coords_tick_len * 0.1;
-        page->exclusion_regions[page->exclusion_region_counter].y_max = y + graph_coords_tick_len * 0.1;
-        page->exclusion_region_counter++;
-
         // Make tick mark
-        if (e->data[i].text_label != NULL) {
+        if (track[i].text_label != NULL) {
             int h_align, v_align;
             const double theta_deg = theta * 180 / M_PI;
 
@@ -650,13 +979,13 @@ void plot_ephemeris(chart_config *s, line_drawer *ld, cairo_page *page, int trac
             if (s->must_show_all_ephemeris_labels || is_first_label) {
                 priority = -1;
             } else {
-                priority = 0.0123 + (1e-12 * i) - (4e-6 * (!e->data[i].sub_month_label));
+                priority = 0.0123 + (1e-12 * i) - (4e-6 * (!track[i].sub_month_label));
             }
 
             // Write text label
-            const double font_size = e->data[i].sub_month_label ? 1.6 : 1.8;
-            const double extra_margin = e->data[i].sub_month_label ? 2 : 0;
-            chart_label_buffer(page, s, s->ephemeris_col, e->data[i].text_label,
+            const double font_size = track[i].sub_month_label ? 1.6 : 1.8;
+            const double extra_margin = track[i].sub_month_label ? 2 : 0;
+            chart_label_buffer(page, s, s->ephemeris_col, track[i].text_label,
                                (label_position[4]) {
                                        {xp_a, yp_a, 0, h_align,  v_align},
                                        {xp_b, yp_b, 0, -h_align, -v_align},
@@ -746,28 +1075,28 @@ double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_outpu
             // Date column
             if (col_widths[0] > 0) {
                 cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                cairo_show_text(s->cairo_draw, "Date");
+                chart_show_text(s, "Date");
                 x += col_widths[0];
             }
 
             // Magnitude column
             if (col_widths[1] > 0) {
                 cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                cairo_show_text(s->cairo_draw, "Mag");
+                chart_show_text(s, "Mag");
                 x += col_widths[1];
             }
 
             // Phase column
             if (col_widths[2] > 0) {
                 cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                cairo_show_text(s->cairo_draw, "Phase");
+                chart_show_text(s, "Phase");
                 x += col_widths[2];
             }
 
             // Angular size column
             if (col_widths[3] > 0) {
                 cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                cairo_show_text(s->cairo_draw, "Angular size");
+                chart_show_text(s, "Angular size");
                 x += col_widths[3];
             }
         }
@@ -836,7 +1165,7 @@ double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_outpu
                 if (col_widths[0] > 0) {
                     sprintf(text_buffer, "%d %.3s %d", year, get_month_name(month), day);
                     cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                    cairo_show_text(s->cairo_draw, text_buffer);
+                    chart_show_text(s, text_buffer);
                     x += col_widths[0];
                 }
 
@@ -844,7 +1173,7 @@ double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_outpu
                 if (col_widths[1] > 0) {
                     sprintf(text_buffer, "%.1f", e->data[j].mag);
                     cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                    cairo_show_text(s->cairo_draw, text_buffer);
+                    chart_show_text(s, text_buffer);
                     x += col_widths[1];
                 }
 
@@ -852,7 +1181,7 @@ double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_outpu
                 if (col_widths[2] > 0) {
                     sprintf(text_buffer, "%.0f%%", e->data[j].phase * 100);
                     cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                    cairo_show_text(s->cairo_draw, text_buffer);
+                    chart_show_text(s, text_buffer);
                     x += col_widths[2];
                 }
 
@@ -861,7 +1190,7 @@ double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_outpu
                     sprintf(text_buffer, "%.1f%c", e->data[j].angular_size / (angular_size_unit == '"' ? 1 : 60),
                             angular_size_unit);
                     cairo_move_to(s->cairo_draw, x * s->cm, y * s->cm);
-                    cairo_show_text(s->cairo_draw, text_buffer);
+                    chart_show_text(s, text_buffer);
                     x += col_widths[3];
                 }
             }
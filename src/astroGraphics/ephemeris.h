@@ -29,6 +29,20 @@
 #include "vectorGraphics/lineDraw.h"
 #include "vectorGraphics/cairo_page.h"
 
+//! The maximum distance, in pixels, between an ephemeris track and the straight lines used to draw it
+#define EPHEMERIS_TRACK_TOLERANCE 0.5
+
+//! The maximum angular distance on the sky, in degrees, between successive points on an ephemeris track. This stops
+//! adaptive sampling from stepping straight over a loop in the track.
+#define EPHEMERIS_TRACK_MAX_STEP 5
+
+//! The maximum number of label exclusion regions placed along any single segment of an ephemeris track
+#define EPHEMERIS_TRACK_MAX_EXCLUSIONS 256
+
+//! The shortest time interval, in days, between successive points on an ephemeris track computed by the built-in
+//! ephemeris engine
+#define EPHEMERIS_TRACK_MIN_INTERVAL (1. / 48)
+
 void ephemerides_fetch(chart_config *s);
 
 void ephemerides_free(chart_config *s);
@@ -37,6 +51,8 @@ void ephemerides_autoscale_plot(chart_config *s, int total_ephemeris_points);
 
 void ephemerides_add_text_labels(chart_config *s);
 
+void ephemerides_sample_tracks(chart_config *s);
+
 void plot_ephemeris(chart_config *s, line_drawer *ld, cairo_page *page, int trace_num);
 
 double draw_ephemeris_table(chart_config *s, double legend_y_pos, int draw_output, double *width_out);
@@ -0,0 +1,212 @@
+// ephemerisCache.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// A cache of ephemerides computed by ephemerisCompute, so that charts which are regenerated repeatedly do not need to
+// run the external tool each time. Each ephemeris is stored in its own file, named after a hash of a key string which
+// describes the object, time span and tool used to compute it. Files are written atomically, by writing to a
+// temporary file which is then renamed, and are read by mapping them into memory.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "astroGraphics/ephemerisCache.h"
+#include "coreUtils/errorReport.h"
+#include "coreUtils/strConstants.h"
+#include "settings/chart_config.h"
+
+// Cache file format version number
+static const int ephemeris_cache_format_version = 1;
+
+//! ephemeris_cache_record - The numeric fields of an ephemeris data point, as stored in the cache
+typedef struct {
+    double jd;
+    double ra, dec; // radians, J2000
+    double mag;
+    double phase; // 0-1
+    double angular_size; // arcseconds
+} ephemeris_cache_record;
+
+//! ephemeris_cache_header - The header at the start of each cache file. It is followed by the key string, including
+//! its null terminator, and then by <point_count> ephemeris_cache_record structures.
+typedef struct {
+    int format_version;
+    int key_length; // Including the null terminator
+    int point_count;
+    int padding; // Ensures the records which follow are aligned
+} ephemeris_cache_header;
+
+//! ephemeris_cache_filename - Work out the filename of the cache file for a particular key. The filename is the
+//! 64-bit FNV-1a hash of the key.
+//! \param cache_dir - The directory where cache files are stored
+//! \param key - The key string describing the ephemeris
+//! \param [out] filename - The character buffer to write the filename into (length FNAME_LENGTH)
+
+static void ephemeris_cache_filename(const char *cache_dir, const char *key, char *filename) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *scan = (const unsigned char *) key; *scan != '\0'; scan++) {
+        hash ^= *scan;
+        hash *= 1099511628211ULL;
+    }
+    snprintf(filename, FNAME_LENGTH, "%.4000s/%016llx.eph", cache_dir, (unsigned long long) hash);
+}
+
+//! ephemeris_cache_read - Look up an ephemeris in the cache
+//! \param cache_dir - The directory where cache files are stored. If empty, caching is disabled.
+//! \param key - The key string describing the ephemeris
+//! \param [out] point_count - The number of data points in the cached ephemeris
+//! \return - A newly malloced array of ephemeris data points, or NULL if the ephemeris was not found in the cache
+
+ephemeris_point *ephemeris_cache_read(const char *cache_dir, const char *key, int *point_count) {
+    char filename[FNAME_LENGTH];
+    struct stat file_status;
+
+    if (cache_dir[0] == '\0') return NULL;
+    ephemeris_cache_filename(cache_dir, key, filename);
+
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    if ((fstat(fd, &file_status) != 0) || (file_status.st_size < (off_t) sizeof(ephemeris_cache_header))) {
+        close(fd);
+        return NULL;
+    }
+
+    const size_t file_size = (size_t) file_status.st_size;
+    void *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    // Check that this file has the expected format, and was created for the same key (rather than one with the
+    // same hash)
+    ephemeris_point *output = NULL;
+    const ephemeris_cache_header *header = (const ephemeris_cache_header *) map;
+    const size_t key_length = strlen(key) + 1;
+    const size_t records_offset = ((sizeof(ephemeris_cache_header) + key_length + sizeof(double) - 1) /
+                                   sizeof(double)) * sizeof(double);
+
+    if ((header->format_version == ephemeris_cache_format_version) &&
+        (header->key_length == (int) key_length) && (header->point_count > 0) &&
+        (file_size == records_offset + header->point_count * sizeof(ephemeris_cache_record)) &&
+        (memcmp((const char *) map + sizeof(ephemeris_cache_header), key, key_length) == 0)) {
+        const ephemeris_cache_record *records = (const ephemeris_cache_record *) ((const char *) map +
+                                                                                  records_offset);
+        output = (ephemeris_point *) malloc(header->point_count * sizeof(ephemeris_point));
+        if (output == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
+
+        for (int i = 0; i < header->point_count; i++) {
+            output[i].jd = records[i].jd;
+            output[i].ra = records[i].ra;
+            output[i].dec = records[i].dec;
+            output[i].mag = records[i].mag;
+            output[i].phase = records[i].phase;
+            output[i].angular_size = records[i].angular_size;
+            output[i].text_label = NULL;
+            output[i].sub_month_label = 0;
+        }
+        *point_count = header->point_count;
+    }
+
+    munmap(map, file_size);
+    return output;
+}
+
+//! ephemeris_cache_write - Store an ephemeris in the cache. Failures are not fatal; the ephemeris is simply not
+//! cached.
+//! \param cache_dir - The directory where cache files are stored. If empty, caching is disabled.
+//! \param key - The key string describing the ephemeris
+//! \param points - The data points of the ephemeris
+//! \param point_count - The number of data points
+
+void ephemeris_cache_write(const char *cache_dir, const char *key, const ephemeris_point *points, int point_count) {
+    char filename[FNAME_LENGTH], temporary_filename[FNAME_LENGTH];
+
+    if ((cache_dir[0] == '\0') || (point_count <= 0)) return;
+    ephemeris_cache_filename(cache_dir, key, filename);
+
+    // Create the cache directory if it doesn't already exist
+    mkdir(cache_dir, 0777);
+
+    // Create a uniquely-named temporary file, since other threads or processes may be writing the same ephemeris
+    int fd = -1;
+    for (int attempt = 0; (fd < 0) && (attempt < 100); attempt++) {
+        snprintf(temporary_filename, FNAME_LENGTH, "%.4000s.%d.%d.tmp", filename, (int) getpid(), attempt);
+        fd = open(temporary_filename, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    }
+    FILE *out = (fd < 0) ? NULL : fdopen(fd, "wb");
+    if (out == NULL) {
+        if (fd >= 0) {
+            close(fd);
+            remove(temporary_filename);
+        }
+        if (DEBUG) {
+            char message[FNAME_LENGTH];
+            snprintf(message, FNAME_LENGTH, "Could not write ephemeris cache file <%s>.", temporary_filename);
+#pragma omp critical (stch_log)
+            stch_log(message);
+        }
+        return;
+    }
+
+    // Write the header and the key, padded so that the records which follow are aligned
+    const size_t key_length = strlen(key) + 1;
+    const size_t records_offset = ((sizeof(ephemeris_cache_header) + key_length + sizeof(double) - 1) /
+                                   sizeof(double)) * sizeof(double);
+    ephemeris_cache_header header;
+    memset(&header, 0, sizeof(header));
+    header.format_version = ephemeris_cache_format_version;
+    header.key_length = (int) key_length;
+    header.point_count = point_count;
+
+    int ok = (fwrite(&header, sizeof(header), 1, out) == 1);
+    ok = ok && (fwrite(key, key_length, 1, out) == 1);
+    for (size_t i = sizeof(header) + key_length; ok && (i < records_offset); i++) ok = (fputc(0, out) != EOF);
+
+    // Write the numeric fields of each data point
+    for (int i = 0; ok && (i < point_count); i++) {
+        ephemeris_cache_record record;
+        record.jd = points[i].jd;
+        record.ra = points[i].ra;
+        record.dec = points[i].dec;
+        record.mag = points[i].mag;
+        record.phase = points[i].phase;
+        record.angular_size = points[i].angular_size;
+        ok = (fwrite(&record, sizeof(record), 1, out) == 1);
+    }
+    ok = (fclose(out) == 0) && ok;
+
+    // Move the completed file into place, so that other processes never see a partially-written file
+    if ((!ok) || (rename(temporary_filename, filename) != 0)) {
+        remove(temporary_filename);
+        if (DEBUG) {
+            char message[FNAME_LENGTH];
+            snprintf(message, FNAME_LENGTH, "Could not write ephemeris cache file <%s>.", filename);
+#pragma omp critical (stch_log)
+            stch_log(message);
+        }
+    }
+}
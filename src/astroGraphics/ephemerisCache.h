@@ -0,0 +1,31 @@
+// ephemerisCache.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef EPHEMERIS_CACHE_H
+#define EPHEMERIS_CACHE_H 1
+
+#include "settings/chart_config.h"
+
+ephemeris_point *ephemeris_cache_read(const char *cache_dir, const char *key, int *point_count);
+
+void ephemeris_cache_write(const char *cache_dir, const char *key, const ephemeris_point *points, int point_count);
+
+#endif
@@ -56,7 +56,10 @@ void read_galaxy_map(chart_config *s) {
     if (in == NULL) stch_fatal(__FILE__, __LINE__, "Could not open galaxy map datafile");
     dcf_fread((void *) &map_h_size, sizeof(int), 1, in);
     dcf_fread((void *) &map_v_size, sizeof(int), 1, in);
-    galaxy_data = (unsigned char *) lt_malloc(map_h_size * map_v_size);
+
+    // The map is cached between charts, so allocate it in the top-level memory context, which is not freed when
+    // each chart is finished
+    galaxy_data = (unsigned char *) lt_malloc_incontext(map_h_size * map_v_size, 0);
     if (galaxy_data == NULL) stch_fatal(__FILE__, __LINE__, "Malloc fail");
     dcf_fread((void *) galaxy_data, sizeof(char), map_h_size * map_v_size, in);
     fclose(in);
@@ -67,11 +70,18 @@ void read_galaxy_map(chart_config *s) {
 
 void plot_galaxy_map(chart_config *s) {
     int j;
-    const int width = s->galaxy_map_width_pixels;
-    const int height = (int) (s->galaxy_map_width_pixels * s->aspect);
 
     if (galaxy_data == NULL) read_galaxy_map(s);
 
+    // Render the map with as many pixels as the chart has in the highest-resolution output file, but no more than
+    // the resolution of the source map, beyond which cairo can upscale the image just as well. This keeps the raster
+    // small when rendering large PNG files in bands.
+    const double map_pixels_per_radian = gsl_max(map_h_size / (2 * M_PI), map_v_size / M_PI);
+    const double output_width = gsl_min(ceil(s->width * 0.393701 * s->raster_dpi),
+                                        ceil(s->wlin * map_pixels_per_radian));
+    const int width = (int) gsl_max(s->galaxy_map_width_pixels, output_width);
+    const int height = (int) (width * s->aspect);
+
     // Generate image RGB data
     const int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
 
@@ -135,5 +145,6 @@ void plot_galaxy_map(chart_config *s) {
 
     // Destroy surface we created
     cairo_surface_finish(surface);
+    cairo_surface_destroy(surface);
     free(pixel_data);
 }
@@ -32,18 +32,34 @@
 #include "mathsTools/projection.h"
 #include "mathsTools/sphericalTrig.h"
 #include "settings/chart_config.h"
+#include "vectorGraphics/curveTracer.h"
 #include "vectorGraphics/lineDraw.h"
 #include "vectorGraphics/cairo_page.h"
 
-//! The number of samples along the length of a great circle to be plotted across the sky
-#define N_SAMPLES 720
-
 //! A label to place along the length of a great circle
 typedef struct {
     char label[16];
     double xpos;
 } gc_label;
 
+//! great_circle_with_pole - Describe the great circle perpendicular to a given pole
+//! \param [out] out - The great circle
+//! \param ra0 - The right ascension of the pole (radians)
+//! \param dec0 - The declination of the pole (radians)
+
+static void great_circle_with_pole(sky_circle *out, double ra0, double dec0) {
+    out->centre[0] = out->centre[1] = out->centre[2] = 0;
+    out->u[0] = 1;
+    out->u[1] = out->u[2] = 0;
+    out->v[1] = 1;
+    out->v[0] = out->v[2] = 0;
+
+    rotate_xz(out->u, out->u, dec0 - (M_PI / 2));
+    rotate_xy(out->u, out->u, ra0);
+    rotate_xz(out->v, out->v, dec0 - (M_PI / 2));
+    rotate_xy(out->v, out->v, ra0);
+}
+
 //! plot_great_circle - Plot a great circle across the sky
 //! \param ra0 - The right ascension of the pole that the great circle lies perpendicular to (degrees)
 //! \param dec0 - The declination of the pole that the great circle lies perpendicular to (degrees)
@@ -59,20 +75,10 @@ static void plot_great_circle(double ra0, double dec0, chart_config *s, line_dra
     int i;
     ra0 = ra0 * M_PI / 180;
     dec0 = dec0 * M_PI / 180;
+    sky_circle circle;
+    great_circle_with_pole(&circle, ra0, dec0);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
-    for (i = 0; i <= N_SAMPLES; i++) {
-        const double l = 2 * M_PI * ((double) i) / (N_SAMPLES-1);
-        double a[3] = {cos(l), sin(l), 0.};
-        double ra, dec, x, y;
-
-        rotate_xz(a, a, dec0 - (M_PI / 2));
-        rotate_xy(a, a, ra0);
-
-        dec = asin(a[2]);
-        ra = atan2(a[1], a[0]);
-        plane_project(&x, &y, s, ra, dec, 0);
-        ld_point(ld, x, y, NULL);
-    }
+    trace_sky_circle(s, ld, &circle, 0, 2 * M_PI, 0);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
 
     if (n_labels)
@@ -104,20 +110,10 @@ static void plot_great_half_circle(double ra0, double dec0, chart_config *s, lin
     int i;
     ra0 = ra0 * M_PI / 180;
     dec0 = dec0 * M_PI / 180;
+    sky_circle circle;
+    great_circle_with_pole(&circle, ra0, dec0);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
-    for (i = 0; i <= N_SAMPLES; i++) {
-        const double l = M_PI * ((double) i) / (N_SAMPLES-1);
-        double a[3] = {cos(l), sin(l), 0.};
-        double ra, dec, x, y;
-
-        rotate_xz(a, a, dec0 - (M_PI / 2));
-        rotate_xy(a, a, ra0);
-
-        dec = asin(a[2]);
-        ra = atan2(a[1], a[0]);
-        plane_project(&x, &y, s, ra, dec, 0);
-        ld_point(ld, x, y, NULL);
-    }
+    trace_sky_circle(s, ld, &circle, 0, M_PI, 0);
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
 
     if (n_labels)
@@ -156,7 +152,7 @@ void plot_equator(chart_config *s, line_drawer *ld, cairo_page *page) {
     // Set line colour
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->equator_col.red, s->equator_col.grn, s->equator_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width);
+    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width * s->line_width_base);
 
     plot_great_circle(0, 90, s, ld, page, 0, NULL, s->equator_col);
 }
@@ -183,7 +179,7 @@ void plot_meridian(chart_config *s, line_drawer *ld, cairo_page *page) {
     // Set line colour
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->meridian_col.red, s->meridian_col.grn, s->meridian_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width);
+    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width * s->line_width_base);
 
     plot_great_half_circle(-90, 0, s, ld, page, s->label_meridian ? 17 : 0, labels,
                       s->meridian_col);
@@ -199,7 +195,7 @@ void plot_galactic_plane(chart_config *s, line_drawer *ld, cairo_page *page) {
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->galactic_plane_col.red, s->galactic_plane_col.grn,
                          s->galactic_plane_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width);
+    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width * s->line_width_base);
 
     plot_great_circle((12. + 51. / 60 + 26.282 / 3600.) / 24. * 360., (27. + 7.0 / 60. + 42.01 / 3600.), s,
                       ld, page, 0, NULL, s->galaxy_col);
@@ -227,7 +223,7 @@ void plot_ecliptic(chart_config *s, line_drawer *ld, cairo_page *page) {
     // Set line colour
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->ecliptic_col.red, s->ecliptic_col.grn, s->ecliptic_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width);
+    cairo_set_line_width(s->cairo_draw, s->great_circle_line_width * s->line_width_base);
 
     plot_great_circle(18. / 24. * 360., 90. - 23.4, s, ld, page, s->label_ecliptic ? 12 : 0, labels,
                       s->ecliptic_col);
@@ -284,7 +280,7 @@ double draw_great_circle_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size * 1.25) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
 
         // Advance horizontally to draw the next item in the legend
         x += w_item;
@@ -312,7 +308,7 @@ double draw_great_circle_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size * 1.25) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
 
         // Advance horizontally to draw the next item in the legend
         x += w_item;
@@ -332,7 +328,7 @@ double draw_great_circle_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size * 1.25) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
 
         // Advance horizontally to draw the next item in the legend
         x += w_item;
@@ -357,7 +353,7 @@ double draw_great_circle_key(chart_config *s, double legend_y_pos) {
                       (x + 0.1 + size * 1.25) * s->cm - extents.x_bearing,
                       y1 * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
 
         // Advance horizontally to draw the next item in the legend
         //x += w_item;
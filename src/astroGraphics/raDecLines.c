@@ -29,12 +29,10 @@
 #include "coreUtils/errorReport.h"
 #include "mathsTools/projection.h"
 #include "settings/chart_config.h"
+#include "vectorGraphics/curveTracer.h"
 #include "vectorGraphics/lineDraw.h"
 #include "vectorGraphics/cairo_page.h"
 
-// Number of samples to make along lines of constant RA and Dec
-#define N_POINTS 720
-
 // Small number added to all angles before labels are converted to text, to avoid rounding causing 23o59' to appear
 #define EPSILON_ANGLE 1e-10
 
@@ -44,14 +42,18 @@
 
 static double deg(double x) { return x / M_PI * 180; }
 
+
 //! plot_ra_dec_lines - Trace lines of constant RA and Dec (J2000) onto a star chart
 //! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
 //! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
 
 void plot_ra_dec_lines(chart_config *s, line_drawer *ld) {
-    int i, j;
+    int i;
     char label[FNAME_LENGTH];
 
+    // Count the number of points we project, for debugging purposes
+    int projection_count = 0;
+
     // Work out how many lines we are going to draw
     double degrees_per_cm = (s->angular_width * 180 / M_PI) / s->width;
     int ra_line_count = 24;
@@ -91,7 +93,7 @@ void plot_ra_dec_lines(chart_config *s, line_drawer *ld) {
     // Set line colour
     ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_source_rgb(s->cairo_draw, s->grid_col.red, s->grid_col.grn, s->grid_col.blu);
-    cairo_set_line_width(s->cairo_draw, s->coordinate_grid_line_width);
+    cairo_set_line_width(s->cairo_draw, s->coordinate_grid_line_width * s->line_width_base);
 
     // Set dashed line style
     double dash_style[1] = {0.5 * s->mm};
@@ -147,18 +149,12 @@ void plot_ra_dec_lines(chart_config *s, line_drawer *ld) {
 	// Lines of constant declination create a tick on the round edge of the chart in Alt_Az mode if and only if ordered to do so
         ld_label(ld, label, 1, 0, s->ra_ticks_on_round_edge);
 
-        // Trace the path of this line across chart
-        for (j = 0; j < N_POINTS; j++) {
-            // Scan through declinations from -90 to +90
-            double dec = -M_PI / 2 + M_PI * ((double) j) / (N_POINTS - 1);
-
-            // Project this point onto the drawing canvas
-            double x, y;
-            plane_project(&x, &y, s, ra, dec, 1);
-
-            // Add this point to the line we are drawing
-            ld_point(ld, x, y, NULL);
-        }
+        // Trace the path of this line across chart, scanning through declinations from -90 to +90
+        // This line is a great circle, parameterised by declination
+        const sky_circle ra_line = {{0, 0, 0},
+                                    {cos(ra), sin(ra), 0},
+                                    {0, 0, 1}};
+        projection_count += trace_sky_circle(s, ld, &ra_line, -M_PI / 2, M_PI / 2, 1);
 
         // Lift up the pen at the end of the line
         ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
@@ -218,18 +214,12 @@ void plot_ra_dec_lines(chart_config *s, line_drawer *ld) {
 	// Lines of constant declination create a tick on the round edge of the chart in Alt_Az mode if and only if ordered to do so
         ld_label(ld, label, 0, 1, s->dec_ticks_on_round_edge);
 
-        // Trace the path of this line across chart
-        for (j = 0; j < N_POINTS; j++) {
-            // Scan through right ascensions from 0 to 24 hours
-            double ra = (2 * M_PI) * ((double) j) / (N_POINTS - 1);
-
-            // Project this point onto the drawing canvas
-            double x, y;
-            plane_project(&x, &y, s, ra, dec, 1);
-
-            // Add this point to the line we are drawing
-            ld_point(ld, x, y, NULL);
-        }
+        // Trace the path of this line across chart, scanning through right ascensions from 0 to 24 hours
+        // This line is a small circle around the celestial pole, parameterised by right ascension
+        const sky_circle dec_line = {{0, 0, sin(dec)},
+                                     {cos(dec), 0, 0},
+                                     {0, cos(dec), 0}};
+        projection_count += trace_sky_circle(s, ld, &dec_line, 0, 2 * M_PI, 1);
 
         // Lift up the pen at the end of the line
         ld_pen_up(ld, GSL_NAN, GSL_NAN, NULL, 1);
@@ -237,4 +227,10 @@ void plot_ra_dec_lines(chart_config *s, line_drawer *ld) {
 
     // Unset dashed line style
     cairo_set_dash(s->cairo_draw, NULL, 0, 0);
+
+    if (DEBUG) {
+        char message[FNAME_LENGTH];
+        snprintf(message, FNAME_LENGTH, "Projected %d points to trace RA and Dec lines", projection_count);
+        stch_log(message);
+    }
 }
@@ -142,11 +142,24 @@ void free_binary_star_catalogue_headers(tiling_information *tiles) {
 //! \param dec_index - The Dec tile index within tiling level <level>
 //! \return - Boolean flag indicating whether we need to plot stars from within this tile
 int test_if_tile_in_field_of_view(chart_config *s, int level, int ra_index, int dec_index) {
-    // Does this tile's sky area fall within field of view?
-    const double ra_min = ra_index * (2 * M_PI) / object_tilings[level].ra_bins;
-    const double ra_max = ra_min + (2 * M_PI) / object_tilings[level].ra_bins;
-    const double dec_min = (dec_index / (double) object_tilings[level].dec_bins - 0.5) * M_PI;
-    const double dec_max = dec_min + M_PI / object_tilings[level].dec_bins;
+    return test_if_cell_in_field_of_view(s, object_tilings[level].ra_bins, object_tilings[level].dec_bins,
+                                         ra_index, dec_index);
+}
+
+//! test_if_cell_in_field_of_view - Test if a cell within a regular grid in RA and Dec is visible within the field of
+//! view of a chart
+//! \param s - The chart we are determining field of view for
+//! \param ra_bins - The number of cells into which the RA axis is divided
+//! \param dec_bins - The number of cells into which the Dec axis is divided
+//! \param ra_index - The RA index of the cell
+//! \param dec_index - The Dec index of the cell
+//! \return - Boolean flag indicating whether we need to plot objects from within this cell
+int test_if_cell_in_field_of_view(chart_config *s, int ra_bins, int dec_bins, int ra_index, int dec_index) {
+    // Does this cell's sky area fall within field of view?
+    const double ra_min = ra_index * (2 * M_PI) / ra_bins;
+    const double ra_max = ra_min + (2 * M_PI) / ra_bins;
+    const double dec_min = (dec_index / (double) dec_bins - 0.5) * M_PI;
+    const double dec_max = dec_min + M_PI / dec_bins;
 
     // Does centre of field of view fall within this tile?
     if ((s->ra0 >= ra_min) && (s->ra0 <= ra_max) && (s->dec0 >= dec_min) && (s->dec0 <= dec_max)) return 1;
@@ -170,7 +183,7 @@ int test_if_tile_in_field_of_view(chart_config *s, int level, int ra_index, int
             // Work out where tile-corner appears on chart
             double x, y;
             const double ra = (ra_min * (steps - i) + ra_max * i) / steps;
-            const double dec = (dec_min * (steps - i) + dec_max * i) / steps;
+            const double dec = (dec_min * (steps - j) + dec_max * j) / steps;
             plane_project(&x, &y, s, ra, dec, 0);
 
             // Include this tile if this corner falls inside the plot area
@@ -82,6 +82,8 @@ void free_binary_star_catalogue_headers(tiling_information *tiles);
 
 int test_if_tile_in_field_of_view(chart_config *s, int level, int ra_index, int dec_index);
 
+int test_if_cell_in_field_of_view(chart_config *s, int ra_bins, int dec_bins, int ra_index, int dec_index);
+
 void star_list_to_binary();
 
 #endif
@@ -33,6 +33,7 @@
 #include "mathsTools/projection.h"
 #include "settings/chart_config.h"
 #include "vectorGraphics/cairo_page.h"
+#include "vectorGraphics/spriteAtlas.h"
 
 
 //! strcmp_ascii - Compare two strings, on the basis of ASCII characters only, ignoring UTF8 characters
@@ -211,6 +212,23 @@ double get_star_size(const chart_config *s, double mag) {
     return size;
 }
 
+//! The maximum number of star discs we accumulate into a single cairo path before filling it
+#define STAR_PATH_BATCH 4096
+
+//! fill_star_path - Fill all the star discs which have been accumulated into the current cairo path
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param atlas - The sprite atlas we are also compositing stars with, or NULL if there isn't one.
+//! \param path_length - The number of discs in the current path; reset to zero.
+
+static void fill_star_path(chart_config *s, sprite_atlas *atlas, int *path_length) {
+    if (*path_length == 0) return;
+    if (atlas != NULL) cairo_surface_mark_dirty(s->cairo_surface);
+    cairo_set_source_rgb(s->cairo_draw, s->star_col.red, s->star_col.grn, s->star_col.blu);
+    cairo_fill(s->cairo_draw);
+    if (atlas != NULL) cairo_surface_flush(s->cairo_surface);
+    *path_length = 0;
+}
+
 //! plot_stars - Plot stars onto the star chart
 //! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
 //! \param page - A <cairo_page> structure defining the cairo drawing context.
@@ -226,6 +244,20 @@ void plot_stars(chart_config *s, cairo_page *page) {
     int label_counter = 0;
     int star_counter = 0;
 
+    // When drawing straight onto a PNG image, we composite pre-rendered discs into its pixels, rather than asking
+    // cairo to fill a separate path for each star
+    sprite_atlas *atlas = NULL;
+    if (s->output_format == SW_FORMAT_PNG) {
+        cairo_surface_flush(s->cairo_surface);
+        atlas = sprite_atlas_create(s->cairo_surface, s->star_col);
+    }
+
+    // All stars are the same colour, so we accumulate their discs into a single path and fill them together. This
+    // writes far fewer fill operations into vector output. Overlapping discs are all wound the same way, so they
+    // are filled in the same way as if they were drawn separately.
+    int star_path_length = 0;
+    cairo_new_path(s->cairo_draw);
+
     // Loop over each tiling level
     for (int level = 0;
          (
@@ -282,10 +314,23 @@ void plot_stars(chart_config *s, cairo_page *page) {
                     // Draw a circular splodge on the star chart
                     double x_canvas, y_canvas;
                     fetch_canvas_coordinates(&x_canvas, &y_canvas, x, y, s);
-                    cairo_set_source_rgb(s->cairo_draw, s->star_col.red, s->star_col.grn, s->star_col.blu);
-                    cairo_new_path(s->cairo_draw);
-                    cairo_arc(s->cairo_draw, x_canvas, y_canvas, size * s->dpi, 0, 2 * M_PI);
-                    cairo_fill(s->cairo_draw);
+                    const double radius = size * s->dpi;
+
+                    // Use the sprite atlas if the star lies wholly within the clip region of the chart
+                    const int drawn_from_atlas = (atlas != NULL) &&
+                                                 chart_clip_contains_box(s, x_canvas - radius, x_canvas + radius,
+                                                                         y_canvas - radius, y_canvas + radius) &&
+                                                 sprite_atlas_draw_disc(atlas, x_canvas, y_canvas, radius);
+
+                    if (s->svg_layer != NULL) {
+                        svg_layer_circle(s->svg_layer, x_canvas, y_canvas, radius,
+                                         s->star_col.red, s->star_col.grn, s->star_col.blu);
+                    } else if (!drawn_from_atlas) {
+                        cairo_new_sub_path(s->cairo_draw);
+                        cairo_arc(s->cairo_draw, x_canvas, y_canvas, radius, 0, 2 * M_PI);
+                        star_path_length++;
+                        if (star_path_length >= STAR_PATH_BATCH) fill_star_path(s, atlas, &star_path_length);
+                    }
 
                     // Don't allow text labels to be placed over this star
                     {
@@ -429,6 +474,15 @@ void plot_stars(chart_config *s, cairo_page *page) {
             }
     }
 
+    // Fill any star discs which are still in the path
+    fill_star_path(s, atlas, &star_path_length);
+
+    // Hand the image surface back to cairo
+    if (atlas != NULL) {
+        cairo_surface_mark_dirty(s->cairo_surface);
+        sprite_atlas_destroy(atlas);
+    }
+
     // Close the binary file listing all the stars
     fclose(file);
 
@@ -491,7 +545,7 @@ double draw_magnitude_key(chart_config *s, double legend_y_pos) {
                   (x + w_tag / 2) * s->cm - extents.width / 2 - extents.x_bearing,
                   y1 * s->cm - extents.height / 2 - extents.y_bearing
     );
-    cairo_show_text(s->cairo_draw, heading);
+    chart_show_text(s, heading);
 
     x += w_tag;
 
@@ -520,7 +574,7 @@ double draw_magnitude_key(chart_config *s, double legend_y_pos) {
                       (x_pos + 0.1) * s->cm + size * 1.25 * s->dpi - extents.x_bearing,
                       y_pos * s->cm - extents.height / 2 - extents.y_bearing
         );
-        cairo_show_text(s->cairo_draw, line);
+        chart_show_text(s, line);
     }
 
     const double new_bottom_to_legend_items = y0 + 0.2 + 0.8 * s->magnitude_key_rows;
@@ -25,6 +25,11 @@
 //
 // The integer variable <lt_mem_context> keeps track of the current context, and can be incremented by a call to
 // <lt_descendIntoNewContext> to create a new context.
+//
+// All of the state held by these routines is thread-local (via OpenMP's threadprivate directive), so each thread has
+// its own stack of allocation contexts, and allocations never need to take a lock. Each thread which uses these
+// routines must call <lt_memoryInit> before doing so, and <lt_memoryStop> when it is finished. Memory allocated by
+// one thread must not be freed by another.
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -40,13 +45,15 @@
 // ---------------------------------------------------------
 
 //! current memory allocation context
-int lt_mem_context = -1;
+static int lt_mem_context = -1;
+#pragma omp threadprivate(lt_mem_context)
 
 //! Maximum value of lt_mem_context
 #define PPL_MAX_CONTEXTS 250
 
 //! Storage buffer for error messages
-char temp_merr_string[LSTR_LENGTH];
+static char temp_merr_string[LSTR_LENGTH];
+#pragma omp threadprivate(temp_merr_string)
 
 //! Handler for errors
 void (*mem_error)(char *);
@@ -90,6 +97,7 @@ int lt_descendIntoNewContext() {
         return -1;
     }
     _lt_setMemContext(lt_mem_context + 1);
+    fastmalloc_reset_stats(lt_mem_context);
     if (MEMDEBUG1) {
         snprintf(temp_merr_string, 1024, "Descended into memory context %d.", lt_mem_context);
         (*mem_log)(temp_merr_string);
@@ -139,11 +147,27 @@ int lt_getMemContext() {
     return lt_mem_context;
 }
 
+//! lt_getMemStats - Fetch usage statistics for a memory allocation context on the calling thread
+//! \param context - the number of the allocation context to query
+//! \param [out] out - the structure to populate with usage statistics
+
+void lt_getMemStats(int context, lt_memStats *out) {
+    fastmalloc_stats(context, out);
+}
+
+//! lt_getMemStatsTotal - Fetch usage statistics summed over all memory allocation contexts on the calling thread
+//! \param [out] out - the structure to populate with usage statistics
+
+void lt_getMemStatsTotal(lt_memStats *out) {
+    fastmalloc_stats_total(out);
+}
+
 //! lt_freeAll - Free all memory which has been allocated in the specified allocation context, and in deeper levels
 //! \param context - the number of the allocation context which is to be freed
 
 void lt_freeAll(int context) {
     static int latch = 0;
+#pragma omp threadprivate(latch)
 
     if (latch == 1) return; // Prevent recursive calls
     if (lt_mem_context < 0) return; // Memory management not initialised
@@ -168,6 +192,7 @@ void lt_freeAll(int context) {
 
 void lt_free(int context) {
     static int latch = 0;
+#pragma omp threadprivate(latch)
 
     if (latch == 1) return; // Prevent recursive calls
     latch = 1;
@@ -243,22 +268,32 @@ void *lt_malloc_incontext(int size, int context) {
 
 // Implementation of FASTMALLOC
 
-//! For each allocation context, a pointer to the first chunk of memory which we have malloced
-void **_fastmalloc_firstblocklist;
+//! The state of a single fastmalloc allocation context
+typedef struct {
+    //! Pointer to the first chunk of memory which we have malloced
+    void *first_block;
+
+    //! Pointer to the chunk of memory which we are currently allocating from
+    void *current_block;
+
+    //! The number of bytes which have been allocated from the current block
+    long current_block_alloc_ptr;
 
-//! For each allocation context, a pointer to the chunk of memory which we are currently allocating from
-void **_fastmalloc_currentblocklist;
+    //! Usage statistics for this context
+    lt_memStats stats;
+} fastmalloc_context;
 
-//! For each allocation context, integers recording how many bytes have been allocated from the current block
-long *_fastmalloc_currentblock_alloc_ptr;
+//! For each allocation context, the chain of memory blocks we are allocating from
+static fastmalloc_context *_fastmalloc_contexts;
+#pragma omp threadprivate(_fastmalloc_contexts)
 
-//! Keep statistics on numbers of malloc calls
-long long _fastmalloc_callcount;
-long long _fastmalloc_bytecount;
-long long _fastmalloc_malloccount;
+//! Usage statistics summed over all allocation contexts
+static lt_memStats _fastmalloc_totals;
+#pragma omp threadprivate(_fastmalloc_totals)
 
 //! Boolean flag indicated whether we have been initialised
 static int _fastmalloc_initialised = 0;
+#pragma omp threadprivate(_fastmalloc_initialised)
 
 //! fastmalloc_init - Initialise fastmalloc
 
@@ -266,17 +301,16 @@ void fastmalloc_init() {
     int i;
     if (_fastmalloc_initialised == 1) return;
 
-    _fastmalloc_firstblocklist = (void **) malloc(PPL_MAX_CONTEXTS * sizeof(void *));
-    _fastmalloc_currentblocklist = (void **) malloc(PPL_MAX_CONTEXTS * sizeof(void *));
-    _fastmalloc_currentblock_alloc_ptr = (long *) malloc(PPL_MAX_CONTEXTS * sizeof(long));
+    _fastmalloc_contexts = (fastmalloc_context *) malloc(PPL_MAX_CONTEXTS * sizeof(fastmalloc_context));
 
-    for (i = 0; i < PPL_MAX_CONTEXTS; i++) _fastmalloc_firstblocklist[i] = NULL;
-    for (i = 0; i < PPL_MAX_CONTEXTS; i++) _fastmalloc_currentblocklist[i] = NULL;
-    for (i = 0; i < PPL_MAX_CONTEXTS; i++) _fastmalloc_currentblock_alloc_ptr[i] = 0;
+    for (i = 0; i < PPL_MAX_CONTEXTS; i++) {
+        _fastmalloc_contexts[i].first_block = NULL;
+        _fastmalloc_contexts[i].current_block = NULL;
+        _fastmalloc_contexts[i].current_block_alloc_ptr = 0;
+        memset(&_fastmalloc_contexts[i].stats, 0, sizeof(lt_memStats));
+    }
+    memset(&_fastmalloc_totals, 0, sizeof(lt_memStats));
 
-    _fastmalloc_callcount = 0;
-    _fastmalloc_bytecount = 0;
-    _fastmalloc_malloccount = 0;
     _fastmalloc_initialised = 1;
 }
 
@@ -285,15 +319,14 @@ void fastmalloc_init() {
 void fastmalloc_close() {
     if (_fastmalloc_initialised == 0) return;
     if (DEBUG) {
+        const lt_memStats stats = _fastmalloc_totals;
         snprintf(temp_merr_string, 1024,
-                "FastMalloc shutting down: Reduced %lld calls to fastmalloc, for a total of %lld bytes, to %lld calls to malloc.",
-                _fastmalloc_callcount, _fastmalloc_bytecount, _fastmalloc_malloccount);
+                "FastMalloc shutting down: Reduced %lld calls to fastmalloc, for a total of %lld bytes, to %lld calls to malloc. Peak usage %lld bytes.",
+                stats.call_count, stats.byte_count, stats.malloc_count, stats.high_water_mark);
         (*mem_log)(temp_merr_string);
     }
     fastmalloc_freeall(0);
-    free(_fastmalloc_firstblocklist);
-    free(_fastmalloc_currentblocklist);
-    free(_fastmalloc_currentblock_alloc_ptr);
+    free(_fastmalloc_contexts);
     _fastmalloc_initialised = 0;
 }
 
@@ -306,68 +339,69 @@ void fastmalloc_close() {
 void *fastmalloc(int context, int size) {
     void *ptr, *out;
 
-    _fastmalloc_callcount++;
-    _fastmalloc_bytecount += size;
-
     if ((context < 0) || (context >= PPL_MAX_CONTEXTS)) {
         snprintf(temp_merr_string, 1024, "FastMalloc asked to malloc memory in an unrecognised context %d.", context);
         (*mem_error)(temp_merr_string);
         return NULL;
     }
 
-    if ((_fastmalloc_currentblocklist[context] == NULL) ||
-        (size > (FM_BLOCKSIZE - 2 - _fastmalloc_currentblock_alloc_ptr[context])))
-    {
+    fastmalloc_context *c = &_fastmalloc_contexts[context];
+
+    c->stats.call_count++;
+    c->stats.byte_count += size;
+    _fastmalloc_totals.call_count++;
+    _fastmalloc_totals.byte_count += size;
+
+    if ((c->current_block == NULL) || (size > (FM_BLOCKSIZE - 2 - c->current_block_alloc_ptr))) {
         // We need to malloc a new block
-        _fastmalloc_malloccount++;
+        long block_size;
+
         if (size > FM_BLOCKSIZE - sizeof(void **)) {
             // This is a big malloc which needs to new block to itself
-
-            if (MEMDEBUG1) {
-                snprintf(temp_merr_string, 1024, "Fastmalloc creating block of size %d bytes at memory level %d.", size,
-                        context);
-                (*mem_log)(temp_merr_string);
-            }
-
-            if ((ptr = malloc(size + SYNCSTEP + sizeof(void **))) == NULL) {
-                (*mem_error)("Out of memory.");
-                return NULL;
-            }
+            block_size = size + SYNCSTEP + sizeof(void **);
         } else {
             // Malloc a new standard sized block
-            if (MEMDEBUG1) {
-                snprintf(temp_merr_string, 1024, "Fastmalloc creating block of size %d bytes at memory level %d.",
-                        FM_BLOCKSIZE, context);
-                (*mem_log)(temp_merr_string);
-            }
-
-            if ((ptr = malloc(FM_BLOCKSIZE)) == NULL) {
-                (*mem_error)("Out of memory.");
-                return NULL;
-            }
+            block_size = FM_BLOCKSIZE;
         }
+
+        if (MEMDEBUG1) {
+            snprintf(temp_merr_string, 1024, "Fastmalloc creating block of size %ld bytes at memory level %d.",
+                     block_size, context);
+            (*mem_log)(temp_merr_string);
+        }
+
+        if ((ptr = malloc(block_size)) == NULL) {
+            (*mem_error)("Out of memory.");
+            return NULL;
+        }
+
+        // Update statistics on the memory held by this context
+        c->stats.malloc_count++;
+        c->stats.bytes_held += block_size;
+        if (c->stats.bytes_held > c->stats.high_water_mark) c->stats.high_water_mark = c->stats.bytes_held;
+        _fastmalloc_totals.malloc_count++;
+        _fastmalloc_totals.bytes_held += block_size;
+        if (_fastmalloc_totals.bytes_held > _fastmalloc_totals.high_water_mark) {
+            _fastmalloc_totals.high_water_mark = _fastmalloc_totals.bytes_held;
+        }
+
         *((void **) ptr) = NULL; // Link to next block in chain
-        if (_fastmalloc_currentblocklist[context] == NULL)
-            _fastmalloc_firstblocklist[context] = ptr; // Insert link into previous block in chain
-        else *((void **) _fastmalloc_currentblocklist[context]) = ptr;
-        _fastmalloc_currentblocklist[context] = ptr;
+        if (c->current_block == NULL) c->first_block = ptr; // Insert link into previous block in chain
+        else *((void **) c->current_block) = ptr;
+        c->current_block = ptr;
 
         // Fast-forward over link to next block
-        _fastmalloc_currentblock_alloc_ptr[context] = (sizeof(void **) + (SYNCSTEP - 1));
-        _fastmalloc_currentblock_alloc_ptr[context] -= (_fastmalloc_currentblock_alloc_ptr[context] % SYNCSTEP);
-        out = ptr + _fastmalloc_currentblock_alloc_ptr[context];
-
-        // Fast-forward over block we have just allocated
-        _fastmalloc_currentblock_alloc_ptr[context] += (size + (SYNCSTEP - 1));
-        _fastmalloc_currentblock_alloc_ptr[context] -= (_fastmalloc_currentblock_alloc_ptr[context] % SYNCSTEP);
-    } else {
-        // There is room for this malloc in the old block
-        out = _fastmalloc_currentblocklist[context] + _fastmalloc_currentblock_alloc_ptr[context];
-
-        // Fast-forward over block we have just allocated
-        _fastmalloc_currentblock_alloc_ptr[context] += (size + (SYNCSTEP - 1));
-        _fastmalloc_currentblock_alloc_ptr[context] -= (_fastmalloc_currentblock_alloc_ptr[context] % SYNCSTEP);
+        c->current_block_alloc_ptr = (sizeof(void **) + (SYNCSTEP - 1));
+        c->current_block_alloc_ptr -= (c->current_block_alloc_ptr % SYNCSTEP);
     }
+
+    // Bump-allocate from the current block
+    out = c->current_block + c->current_block_alloc_ptr;
+
+    // Fast-forward over block we have just allocated
+    c->current_block_alloc_ptr += (size + (SYNCSTEP - 1));
+    c->current_block_alloc_ptr -= (c->current_block_alloc_ptr % SYNCSTEP);
+
     return out;
 }
 
@@ -376,33 +410,60 @@ void *fastmalloc(int context, int size) {
 
 void fastmalloc_freeall(int context) {
     int i;
-    void *ptr, *ptr2;
-    for (i = context; i < PPL_MAX_CONTEXTS; i++) {
-        ptr = _fastmalloc_firstblocklist[i];
-        while (ptr != NULL) {
-            ptr2 = *((void **) ptr);
-            free(ptr);
-            ptr = ptr2;
-        }
-        _fastmalloc_firstblocklist[i] = NULL;
-        _fastmalloc_currentblocklist[i] = NULL;
-        _fastmalloc_currentblock_alloc_ptr[i] = 0;
-    }
+    for (i = context; i < PPL_MAX_CONTEXTS; i++) fastmalloc_free(i);
 }
 
-//! fastmalloc_freeall - Free all memory assigned within an allocation context
+//! fastmalloc_free - Free all memory assigned within an allocation context
 //! \param context - The memory allocation context to free
 
 void fastmalloc_free(int context) {
     void *ptr, *ptr2;
-    ptr = _fastmalloc_firstblocklist[context];
+    fastmalloc_context *c = &_fastmalloc_contexts[context];
+    ptr = c->first_block;
     while (ptr != NULL) {
         ptr2 = *((void **) ptr);
         free(ptr);
         ptr = ptr2;
     }
-    _fastmalloc_firstblocklist[context] = NULL;
-    _fastmalloc_currentblocklist[context] = NULL;
-    _fastmalloc_currentblock_alloc_ptr[context] = 0;
+    c->first_block = NULL;
+    c->current_block = NULL;
+    c->current_block_alloc_ptr = 0;
+    _fastmalloc_totals.bytes_held -= c->stats.bytes_held;
+    c->stats.bytes_held = 0;
+}
+
+//! fastmalloc_reset_stats - Reset the usage statistics for an allocation context, which should be empty
+//! \param context - The memory allocation context to reset
+
+void fastmalloc_reset_stats(int context) {
+    fastmalloc_context *c = &_fastmalloc_contexts[context];
+    const long long bytes_held = c->stats.bytes_held;
+    memset(&c->stats, 0, sizeof(lt_memStats));
+    c->stats.bytes_held = bytes_held;
+    c->stats.high_water_mark = bytes_held;
+}
+
+//! fastmalloc_stats - Fetch usage statistics for a single allocation context on the calling thread. These count
+//! activity since the context was last entered via <lt_descendIntoNewContext>.
+//! \param context - The memory allocation context to query
+//! \param [out] out - The structure to populate with usage statistics
+
+void fastmalloc_stats(int context, lt_memStats *out) {
+    if ((_fastmalloc_initialised == 0) || (context < 0) || (context >= PPL_MAX_CONTEXTS)) {
+        memset(out, 0, sizeof(lt_memStats));
+        return;
+    }
+    *out = _fastmalloc_contexts[context].stats;
 }
 
+//! fastmalloc_stats_total - Fetch usage statistics summed over all the allocation contexts on the calling thread,
+//! since fastmalloc was initialised
+//! \param [out] out - The structure to populate with usage statistics
+
+void fastmalloc_stats_total(lt_memStats *out) {
+    if (_fastmalloc_initialised == 0) {
+        memset(out, 0, sizeof(lt_memStats));
+        return;
+    }
+    *out = _fastmalloc_totals;
+}
@@ -22,6 +22,24 @@
 #ifndef LT_MEMORY_H
 #define LT_MEMORY_H 1
 
+//! Statistics on the memory usage of an allocation context
+typedef struct {
+    //! The number of calls made to fastmalloc
+    long long call_count;
+
+    //! The total number of bytes requested in calls to fastmalloc
+    long long byte_count;
+
+    //! The number of calls made to the system's malloc
+    long long malloc_count;
+
+    //! The number of bytes currently held from the system's malloc
+    long long bytes_held;
+
+    //! The largest number of bytes which have been held from the system's malloc at any one time
+    long long high_water_mark;
+} lt_memStats;
+
 void lt_memoryInit(void(*mem_error_handler)(char *), void(*mem_log_handler)(char *));
 
 void lt_memoryStop();
@@ -34,6 +52,10 @@ void _lt_setMemContext(int context);
 
 int lt_getMemContext();
 
+void lt_getMemStats(int context, lt_memStats *out);
+
+void lt_getMemStatsTotal(lt_memStats *out);
+
 void lt_freeAll(int context);
 
 void lt_free(int context);
@@ -60,5 +82,11 @@ void fastmalloc_freeall(int context);
 
 void fastmalloc_free(int context);
 
+void fastmalloc_reset_stats(int context);
+
+void fastmalloc_stats(int context, lt_memStats *out);
+
+void fastmalloc_stats_total(lt_memStats *out);
+
 #endif
 
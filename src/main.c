@@ -37,6 +37,8 @@
 
 #include "settings/chart_config.h"
 
+#include "astroGraphics/constellationGeometry.h"
+#include "astroGraphics/constellationLookup.h"
 #include "astroGraphics/constellations.h"
 #include "astroGraphics/ephemeris.h"
 #include "astroGraphics/galaxyMap.h"
@@ -57,6 +59,10 @@ void render_chart(chart_config *s) {
     line_drawer ld;
     char line[FNAME_LENGTH];
 
+    // All memory allocated while rendering this chart lives in its own allocation context, which we free when the
+    // chart is finished. This stops memory usage growing when many charts are rendered in a single run.
+    const int memory_context = lt_descendIntoNewContext();
+
     // If we're plotting ephemerides for solar system objects, fetch the data now
     // We do this first, as auto-scaling plots use this data to determine which sky area to show
     ephemerides_fetch(s);
@@ -64,6 +70,9 @@ void render_chart(chart_config *s) {
     // Check star chart configuration, and insert any computed quantities
     config_init(s);
 
+    // Now that the projection is known, work out which points to draw along each ephemeris track
+    ephemerides_sample_tracks(s);
+
     // Create a cairo surface object to render the star chart onto
     cairo_init(&page, s);
 
@@ -154,6 +163,15 @@ void render_chart(chart_config *s) {
     // Free up storage
     ephemerides_free(s);
     config_close(s);
+
+    if (DEBUG) {
+        lt_memStats stats;
+        lt_getMemStats(memory_context, &stats);
+        snprintf(line, FNAME_LENGTH, "Chart used %lld bytes of memory in %lld allocations (peak %lld bytes).",
+                 stats.byte_count, stats.call_count, stats.high_water_mark);
+        stch_log(line);
+    }
+    lt_ascendOutOfContext(memory_context);
 }
 
 // Macro to check that a parameter in a configuration file has a numeric value
@@ -184,6 +202,63 @@ colour colour_from_string(const char *input) {
     return output;
 }
 
+//! which_constellation - Print the abbreviation of the constellation containing each of a list of positions
+//! \param position_count - The number of positions given on the command line. If zero, positions are read from
+//! stdin instead, one per line.
+//! \param positions - The positions, each of the form <ra,dec>, with RA in hours and Dec in degrees (J2000.0)
+//! \return - Zero on success, or one if a position could not be parsed
+
+static int which_constellation(int position_count, char **positions) {
+    char line[LSTR_LENGTH];
+    int line_number = 0;
+    constellation_lookup *index = constellation_lookup_open();
+
+    // Output is buffered, since we may be asked about millions of positions
+    static char output_buffer[1048576];
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+
+    while (1) {
+        const char *position;
+        if (position_count > 0) {
+            if (line_number >= position_count) break;
+            position = positions[line_number++];
+        } else {
+            if (fgets(line, LSTR_LENGTH, stdin) == NULL) break;
+            line_number++;
+            position = line;
+            while ((*position > '\0') && (*position <= ' ')) position++;
+            if ((*position == '\0') || (*position == '#')) continue; // Blank line or comment
+        }
+
+        // Positions may be separated by commas and/or whitespace
+        char *end;
+        const double ra = strtod(position, &end);
+        int valid = (end != position);
+        position = end;
+        while ((*position == ',') || ((*position > '\0') && (*position <= ' '))) position++;
+        const double dec = strtod(position, &end);
+        valid = valid && (end != position);
+
+        if (!valid) {
+            fflush(stdout);
+            snprintf(temp_err_string, FNAME_LENGTH, "Could not parse position %d. Positions should be given in the "
+                                                    "form <ra,dec>, with RA in hours and Dec in degrees.", line_number);
+            stch_error(temp_err_string);
+            constellation_lookup_close(index);
+            return 1;
+        }
+
+        const int constellation_id = constellation_lookup_point(index, ra * M_PI / 12, dec * M_PI / 180);
+        const char *abbreviation = constellation_abbreviation(constellation_id);
+        fputs((abbreviation != NULL) ? abbreviation : "---", stdout);
+        fputc('\n', stdout);
+    }
+
+    fflush(stdout);
+    constellation_lookup_close(index);
+    return 0;
+}
+
 //! Main entry point for rendering a single star chart, or a sequence of star charts, as described in a configuration
 //! file. On the command line, the user should either supply a single filename for a configuration file to read, or
 //! else the configuration is expected to be supplied on stdin.
@@ -214,8 +289,12 @@ int main(int argc, char **argv) {
     snprintf(help_string, FNAME_LENGTH, "StarCharter %s\n"
                                         "%s\n\n"
                                         "Usage: starchart.bin <filename>\n"
+                                        "       starchart.bin --which-constellation [<ra,dec> ...]\n"
                                         "-h, --help:       Display this help.\n"
-                                        "-v, --version:    Display version number.",
+                                        "-v, --version:    Display version number.\n"
+                                        "--which-constellation: Print the constellation containing each position, with\n"
+                                        "                  RA in hours and Dec in degrees (J2000). Positions are read\n"
+                                        "                  from stdin, one per line, if none are given.",
              DCFVERSION, str_underline(version_string, version_string_underline));
 
     // Scan command line options for any switches
@@ -240,6 +319,9 @@ int main(int argc, char **argv) {
             // Switches -h and --help cause the usage string to be displayed
             stch_report(help_string);
             return 0;
+        } else if (strcmp(argv[i], "--which-constellation") == 0) {
+            // Switch --which-constellation looks up the constellations containing all the positions which follow
+            return which_constellation(argc - i - 1, argv + i + 1);
         } else {
             // Return an error if an unknown switch is received
             snprintf(temp_err_string, FNAME_LENGTH,
@@ -379,9 +461,59 @@ int main(int argc, char **argv) {
             continue;
         } else if (strcmp(key, "output_filename") == 0) {
             //! output_filename - The target filename for the star chart. The file type (svg, png, eps or pdf) is
-            //! inferred from the file extension.
+            //! inferred from the file extension. A comma-separated list of filenames may be given, in which case the
+            //! chart is drawn once and written to each file in turn. A filename of "-" writes the chart to stdout.
             strcpy(settings_destination->output_filename, key_val);
             continue;
+        } else if (strcmp(key, "dpi") == 0) {
+            //! dpi - The resolution of PNG output, in pixels per inch. Changing this scales the output image without
+            //! changing the layout of the chart. Default 100.
+            CHECK_KEYVALNUM("dpi")
+            if (key_val_num <= 0) {
+                snprintf(temp_err_string, FNAME_LENGTH, "Bad input file. dpi should be greater than zero.");
+                stch_error(temp_err_string);
+                return 1;
+            }
+            settings_destination->png_dpi = key_val_num;
+            continue;
+        } else if (strcmp(key, "png_band_height") == 0) {
+            //! png_band_height - If greater than zero, render PNG files in horizontal bands of this many pixels, so
+            //! that very large images can be produced without holding the whole image in memory. Default 0.
+            CHECK_KEYVALNUM("png_band_height")
+            settings_destination->png_band_height = (int) key_val_num;
+            continue;
+        } else if (strcmp(key, "svg_compact") == 0) {
+            //! svg_compact - Boolean (0 or 1) indicating whether to write SVG files with our own compact SVG writer,
+            //! which writes stars as reusable symbols and text as <text> elements. Default 0.
+            CHECK_KEYVALNUM("svg_compact")
+            settings_destination->svg_compact = (int) key_val_num;
+            continue;
+        } else if (strcmp(key, "line_simplification") == 0) {
+            //! line_simplification - The maximum distance, in device pixels, by which lines may deviate from their
+            //! sampled points when runs of nearly-collinear segments are merged. Zero disables. Default 0.1.
+            CHECK_KEYVALNUM("line_simplification")
+            settings_destination->line_simplification = key_val_num;
+            continue;
+        } else if (strcmp(key, "png_compression_level") == 0) {
+            //! png_compression_level - The zlib compression level to use when writing PNG files, from 0 (fastest) to 9
+            //! (smallest). Default 6.
+            CHECK_KEYVALNUM("png_compression_level")
+            settings_destination->png_compression_level = (int) key_val_num;
+            continue;
+        } else if (strcmp(key, "stdout_format") == 0) {
+            //! stdout_format - The image format to use when the chart is written to stdout. Set to 'svg', 'png',
+            //! 'eps' or 'pdf'.
+            if (strcmp(key_val, "svg") == 0) settings_destination->stdout_format = SW_FORMAT_SVG;
+            else if (strcmp(key_val, "png") == 0) settings_destination->stdout_format = SW_FORMAT_PNG;
+            else if (strcmp(key_val, "eps") == 0) settings_destination->stdout_format = SW_FORMAT_EPS;
+            else if (strcmp(key_val, "pdf") == 0) settings_destination->stdout_format = SW_FORMAT_PDF;
+            else {
+                snprintf(temp_err_string, FNAME_LENGTH,
+                         "Bad input file. stdout_format should equal 'svg', 'png', 'eps' or 'pdf'.");
+                stch_error(temp_err_string);
+                return 1;
+            }
+            continue;
         } else if (strcmp(key, "galaxy_map_filename") == 0) {
             //! galaxy_map_filename - The binary file from which to read the shaded map of the Milky Way
             strcpy(settings_destination->galaxy_map_filename, key_val);
@@ -571,6 +703,17 @@ int main(int argc, char **argv) {
             strncpy(settings_destination->constellation_highlight, key_val, 6);
             settings_destination->constellation_highlight[6] = '\0';
             continue;
+        } else if (strcmp(key, "constellations") == 0) {
+            //! constellations - Optionally restrict the constellations whose boundaries, stick figures and names are
+            //! drawn to a comma-separated list of three-letter abbreviations, e.g. ORI,TAU,GEM
+            if (constellation_mask_from_list(key_val, settings_destination->constellation_selection) != 0) {
+                snprintf(temp_err_string, FNAME_LENGTH, "Bad input file. "
+                                                        "constellations should be a comma-separated list of "
+                                                        "three-letter constellation abbreviations.");
+                stch_error(temp_err_string);
+                return 1;
+            }
+            continue;
         } else if (strcmp(key, "plot_stars") == 0) {
             //! plot_stars - Boolean (0 or 1) indicating whether we plot any stars
             CHECK_KEYVALNUM("plot_stars")
@@ -845,6 +988,27 @@ int main(int argc, char **argv) {
             //! same directory as StarCharter, the default value should be <../ephemeris-compute-de430/bin/ephem.bin>.
             strcpy(settings_destination->ephemeris_compute_path, key_val);
             continue;
+        } else if (strcmp(key, "ephemeris_engine") == 0) {
+            //! ephemeris_engine - Select how we compute the paths of solar system objects. Set to either 'builtin' or
+            //! 'ephemeris_compute'.
+            if (strcmp(key_val, "builtin") == 0) {
+                settings_destination->ephemeris_engine = SW_EPHEMERIS_BUILTIN;
+            } else if (strcmp(key_val, "ephemeris_compute") == 0) {
+                settings_destination->ephemeris_engine = SW_EPHEMERIS_COMPUTE;
+            } else {
+                snprintf(temp_err_string, FNAME_LENGTH, "Bad input file. "
+                                                        "ephemeris_engine should equal 'builtin' or "
+                                                        "'ephemeris_compute'.");
+                stch_error(temp_err_string);
+                return 1;
+            }
+            continue;
+        } else if (strcmp(key, "ephemeris_cache_dir") == 0) {
+            //! ephemeris_cache_dir - The directory in which to cache ephemerides computed by <ephemerisCompute>, so
+            //! that they do not need to be recomputed when a chart is redrawn. Set to an empty string to disable
+            //! caching.
+            strcpy(settings_destination->ephemeris_cache_dir, key_val);
+            continue;
         } else {
             snprintf(temp_err_string, FNAME_LENGTH, "Bad input file. Unrecognised setting '%s'.", key);
             stch_error(temp_err_string);
@@ -0,0 +1,384 @@
+// ephemerisEngine.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// A built-in ephemeris engine for the Sun, Moon and planets, which allows the paths of these objects to be computed
+// without running the external tool ephemerisCompute.
+//
+// The planets are computed from the Keplerian orbital elements of Standish (JPL), "Keplerian Elements for
+// Approximate Positions of the Major Planets", which are fitted to DE405 over the period 1800-2050. The Moon is
+// computed from the principal terms of the ELP-2000/82 lunar theory, as tabulated by Meeus, "Astronomical Algorithms",
+// chapter 47. Positions are astrometric, relative to the mean equator and equinox of J2000.0. Using Standish's
+// elements for 1800-2050, without the additional perturbation terms for the outer planets, the positions of the inner
+// planets are accurate to around an arcminute, but errors reach several arcminutes for Uranus and Neptune, and around
+// ten arcminutes for Jupiter and Saturn. Outside of 1800-2050 the errors grow rapidly, so we decline to compute
+// positions outside of this range.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+
+#include "mathsTools/ephemerisEngine.h"
+#include "settings/chart_config.h"
+
+//! The obliquity of the ecliptic at J2000.0 (radians)
+#define EPHEMERIS_OBLIQUITY_J2000 (23.43928 * M_PI / 180)
+
+//! The light travel time across one astronomical unit (days)
+#define EPHEMERIS_LIGHT_TIME_PER_AU 0.0057755183
+
+//! The length of an astronomical unit (km)
+#define EPHEMERIS_AU_KM 149597870.7
+
+//! The ratio of the mass of the Earth to that of the Moon
+#define EPHEMERIS_EARTH_MOON_MASS_RATIO 81.30056
+
+//! The Julian day number of the epoch J2000.0
+#define EPHEMERIS_JD_J2000 2451545.0
+
+//! The range of Julian day numbers over which the orbital elements are valid (1800 Jan 1 to 2050 Jan 1)
+#define EPHEMERIS_JD_VALID_START 2378496.5
+#define EPHEMERIS_JD_VALID_END 2469807.5
+
+//! The direction of the north pole of Saturn's rings, in J2000 equatorial coordinates (radians)
+#define EPHEMERIS_SATURN_POLE_RA (40.589 * M_PI / 180)
+#define EPHEMERIS_SATURN_POLE_DEC (83.537 * M_PI / 180)
+
+//! Keplerian orbital elements of the planets, and their rates of change per Julian century, relative to the mean
+//! ecliptic and equinox of J2000.0. Index 3 is the Earth-Moon barycentre.
+//! a (AU), e, I (deg), L (deg), longitude of perihelion (deg), longitude of ascending node (deg)
+static const double planet_elements[10][12] = {
+        {0},
+        {0.38709927, 0.00000037, 0.20563593, 0.00001906, 7.00497902, -0.00594749,
+                252.25032350, 149472.67411175, 77.45779628, 0.16047689, 48.33076593, -0.12534081},
+        {0.72333566, 0.00000390, 0.00677672, -0.00004107, 3.39467605, -0.00078890,
+                181.97909950, 58517.81538729, 131.60246718, 0.00268329, 76.67984255, -0.27769418},
+        {1.00000261, 0.00000562, 0.01671123, -0.00004392, -0.00001531, -0.01294668,
+                100.46457166, 35999.37244981, 102.93768193, 0.32327364, 0.0, 0.0},
+        {1.52371034, 0.00001847, 0.09339410, 0.00007882, 1.84969142, -0.00813131,
+                -4.55343205, 19140.30268499, -23.94362959, 0.44441088, 49.55953891, -0.29257343},
+        {5.20288700, -0.00011607, 0.04838624, -0.00013253, 1.30439695, -0.00183714,
+                34.39644051, 3034.74612775, 14.72847983, 0.21252668, 100.47390909, 0.20469106},
+        {9.53667594, -0.00125060, 0.05386179, -0.00050991, 2.48599187, 0.00193609,
+                49.95424423, 1222.49362201, 92.59887831, -0.41897216, 113.66242448, -0.28867794},
+        {19.18916464, -0.00196176, 0.04725744, -0.00004397, 0.77263783, -0.00242939,
+                313.23810451, 428.48202785, 170.95427630, 0.40805281, 74.01692503, 0.04240589},
+        {30.06992276, 0.00026291, 0.00859048, 0.00005105, 1.77004347, 0.00035372,
+                -55.12002969, 218.45945325, 44.96476227, -0.32241464, 131.78422574, -0.00508664},
+        {39.48211675, -0.00031596, 0.24882730, 0.00005170, 17.14001206, 0.00004818,
+                238.92903833, 145.20780515, 224.06891629, -0.04062942, 110.30393684, -0.01183482}
+};
+
+//! The equatorial radii of the Sun, planets and Moon (km), indexed by EPHEMERIS_BODY_* constants
+static const double body_radius[11] = {696000, 2439.7, 6051.8, 6378.1, 3396.2, 71492, 60268, 25559, 24764, 1188.3,
+                                       1737.4};
+
+//! Periodic terms in the longitude and distance of the Moon. Multiples of D, M, M', F, followed by the
+//! coefficients of the sine of the argument in longitude (1e-6 deg) and cosine in distance (1e-3 km).
+static const int moon_longitude_terms[][6] = {
+        {0, 0, 1, 0, 6288774, -20905355}, {2, 0, -1, 0, 1274027, -3699111}, {2, 0, 0, 0, 658314, -2955968},
+        {0, 0, 2, 0, 213618, -569925}, {0, 1, 0, 0, -185116, 48888}, {0, 0, 0, 2, -114332, -3149},
+        {2, 0, -2, 0, 58793, 246158}, {2, -1, -1, 0, 57066, -152138}, {2, 0, 1, 0, 53322, -170733},
+        {2, -1, 0, 0, 45758, -204586}, {0, 1, -1, 0, -40923, -129620}, {1, 0, 0, 0, -34720, 108743},
+        {0, 1, 1, 0, -30383, 104755}, {2, 0, 0, -2, 15327, 10321}, {0, 0, 1, 2, -12528, 0},
+        {0, 0, 1, -2, 10980, 79661}, {4, 0, -1, 0, 10675, -34782}, {0, 0, 3, 0, 10034, -23210},
+        {4, 0, -2, 0, 8548, -21636}, {2, 1, -1, 0, -7888, 24208}, {2, 1, 0, 0, -6766, 30824},
+        {1, 0, -1, 0, -5163, -8379}, {1, 1, 0, 0, 4987, -16675}, {2, -1, 1, 0, 4036, -12831},
+        {2, 0, 2, 0, 3994, -10445}, {4, 0, 0, 0, 3861, -11650}, {2, 0, -3, 0, 3665, 14403},
+        {0, 1, -2, 0, -2689, -7003}, {2, 0, -1, 2, -2602, 0}, {2, -1, -2, 0, 2390, 10056},
+        {1, 0, 1, 0, -2348, 6322}, {2, -2, 0, 0, 2236, -9884}, {0, 1, 2, 0, -2120, 5751},
+        {0, 2, 0, 0, -2069, 0}, {2, -2, -1, 0, 2048, -4950}, {2, 0, 1, -2, -1773, 4130},
+        {2, 0, 0, 2, -1595, 0}, {4, -1, -1, 0, 1215, -3958}, {0, 0, 2, 2, -1110, 0},
+        {3, 0, -1, 0, -892, 3258}, {2, 1, 1, 0, -810, 2616}, {4, -1, -2, 0, 759, -1897},
+        {0, 2, -1, 0, -713, -2117}, {2, 2, -1, 0, -700, 2354}, {2, 1, -2, 0, 691, 0},
+        {2, -1, 0, -2, 596, 0}, {4, 0, 1, 0, 549, -1423}, {0, 0, 4, 0, 537, -1117},
+        {4, -1, 0, 0, 520, -1571}, {1, 0, -2, 0, -487, -1739}, {2, 1, 0, -2, -399, 0},
+        {0, 0, 2, -2, -381, -4421}, {1, 1, 1, 0, 351, 0}, {3, 0, -2, 0, -340, 0},
+        {4, 0, -3, 0, 330, 0}, {2, -1, 2, 0, 327, 0}, {0, 2, 1, 0, -323, 1165},
+        {1, 1, -1, 0, 299, 0}, {2, 0, 3, 0, 294, 0}, {2, 0, -1, -2, 0, 8752}
+};
+
+//! Periodic terms in the latitude of the Moon. Multiples of D, M, M', F, followed by the coefficient of the sine of
+//! the argument (1e-6 deg).
+static const int moon_latitude_terms[][5] = {
+        {0, 0, 0, 1, 5128122}, {0, 0, 1, 1, 280602}, {0, 0, 1, -1, 277693}, {2, 0, 0, -1, 173237},
+        {2, 0, -1, 1, 55413}, {2, 0, -1, -1, 46271}, {2, 0, 0, 1, 32573}, {0, 0, 2, 1, 17198},
+        {2, 0, 1, -1, 9266}, {0, 0, 2, -1, 8822}, {2, -1, 0, -1, 8216}, {2, 0, -2, -1, 4324},
+        {2, 0, 1, 1, 4200}, {2, 1, 0, -1, -3359}, {2, -1, -1, 1, 2463}, {2, -1, 0, 1, 2211},
+        {2, -1, -1, -1, 2065}, {0, 1, -1, -1, -1870}, {4, 0, -1, -1, 1828}, {0, 1, 0, 1, -1794},
+        {0, 0, 0, 3, -1749}, {0, 1, -1, 1, -1565}, {1, 0, 0, 1, -1491}, {0, 1, 1, 1, -1475},
+        {0, 1, 1, -1, -1410}, {0, 1, 0, -1, -1344}, {1, 0, 0, -1, -1335}, {0, 0, 3, 1, 1107},
+        {4, 0, 0, -1, 1021}, {4, 0, -1, 1, 833}
+};
+
+//! ephemeris_engine_body_from_name - Look up which body the built-in ephemeris engine should compute for an object
+//! name, as would be passed to ephemerisCompute
+//! \param object_id - The name of the object, e.g. "jupiter", "pjupiter" or "p5"
+//! \param jd_start - The Julian day number of the start of the period over which the object is to be computed
+//! \param jd_end - The Julian day number of the end of the period over which the object is to be computed
+//! \return - One of the EPHEMERIS_BODY_* constants, or -1 if the built-in engine cannot compute this object over
+//! this period
+
+int ephemeris_engine_body_from_name(const char *object_id, double jd_start, double jd_end) {
+    static const char *names[] = {"sun", "mercury", "venus", "earth", "mars", "jupiter", "saturn", "uranus",
+                                  "neptune", "pluto", "moon"};
+    char name[32];
+    int i;
+
+    // Convert name to lower case, dropping any surrounding whitespace
+    while ((*object_id > '\0') && (*object_id <= ' ')) object_id++;
+    for (i = 0; (i < (int) sizeof(name) - 1) && (object_id[i] > ' '); i++) {
+        name[i] = (char) tolower((unsigned char) object_id[i]);
+    }
+    name[i] = '\0';
+
+    int body = -1;
+    if (strcmp(name, "p301") == 0) body = EPHEMERIS_BODY_MOON;
+    else if ((name[0] == 'p') && (name[1] >= '1') && (name[1] <= '9') && (name[2] == '\0')) body = name[1] - '0';
+    else {
+        const char *bare_name = (name[0] == 'p') ? name + 1 : name;
+        for (i = 0; i < 11; i++) {
+            if ((strcmp(name, names[i]) == 0) || (strcmp(bare_name, names[i]) == 0)) body = i;
+        }
+    }
+
+    // We cannot compute the position of the Earth as seen from the Earth
+    if (body == EPHEMERIS_BODY_EARTH) return -1;
+
+    // The orbital elements we use are only valid between 1800 and 2050
+    if ((jd_start < EPHEMERIS_JD_VALID_START) || (jd_end > EPHEMERIS_JD_VALID_END)) return -1;
+    return body;
+}
+
+//! ecliptic_to_equatorial - Rotate a vector from J2000 ecliptic coordinates into J2000 equatorial coordinates
+//! \param [in,out] v - The vector to rotate
+
+static void ecliptic_to_equatorial(double *v) {
+    const double y = v[1], z = v[2];
+    v[1] = cos(EPHEMERIS_OBLIQUITY_J2000) * y - sin(EPHEMERIS_OBLIQUITY_J2000) * z;
+    v[2] = sin(EPHEMERIS_OBLIQUITY_J2000) * y + cos(EPHEMERIS_OBLIQUITY_J2000) * z;
+}
+
+//! solve_kepler - Solve Kepler's equation, M = E - e sin(E), for the eccentric anomaly E
+//! \param mean_anomaly - The mean anomaly, M (radians)
+//! \param eccentricity - The eccentricity of the orbit, e < 1
+//! \return - The eccentric anomaly, E (radians)
+
+static double solve_kepler(double mean_anomaly, double eccentricity) {
+    double e_anomaly = mean_anomaly + eccentricity * sin(mean_anomaly);
+    for (int i = 0; i < 30; i++) {
+        const double delta = ((e_anomaly - eccentricity * sin(e_anomaly) - mean_anomaly) /
+                              (1 - eccentricity * cos(e_anomaly)));
+        e_anomaly -= delta;
+        if (fabs(delta) < 1e-12) break;
+    }
+    return e_anomaly;
+}
+
+//! planet_heliocentric - Compute the heliocentric position of a planet, or the Earth-Moon barycentre
+//! \param planet - The planet number, 1-9
+//! \param jd - The Julian day number (TT)
+//! \param [out] v - The heliocentric position of the planet, in J2000 equatorial coordinates (AU)
+
+static void planet_heliocentric(int planet, double jd, double *v) {
+    const double *el = planet_elements[planet];
+    const double t = (jd - EPHEMERIS_JD_J2000) / 36525;
+    const double a = el[0] + el[1] * t;
+    const double e = el[2] + el[3] * t;
+    const double inc = (el[4] + el[5] * t) * M_PI / 180;
+    const double mean_longitude = (el[6] + el[7] * t) * M_PI / 180;
+    const double perihelion = (el[8] + el[9] * t) * M_PI / 180;
+    const double node = (el[10] + el[11] * t) * M_PI / 180;
+
+    // Solve for the position of the planet in the plane of its orbit
+    const double arg_perihelion = perihelion - node;
+    const double mean_anomaly = fmod(mean_longitude - perihelion, 2 * M_PI);
+    const double e_anomaly = solve_kepler(mean_anomaly, e);
+    const double xp = a * (cos(e_anomaly) - e);
+    const double yp = a * sqrt(1 - e * e) * sin(e_anomaly);
+
+    // Rotate into the J2000 ecliptic frame
+    const double cw = cos(arg_perihelion), sw = sin(arg_perihelion);
+    const double cn = cos(node), sn = sin(node);
+    const double ci = cos(inc), si = sin(inc);
+    v[0] = (cw * cn - sw * sn * ci) * xp + (-sw * cn - cw * sn * ci) * yp;
+    v[1] = (cw * sn + sw * cn * ci) * xp + (-sw * sn + cw * cn * ci) * yp;
+    v[2] = (sw * si) * xp + (cw * si) * yp;
+    ecliptic_to_equatorial(v);
+}
+
+//! moon_geocentric - Compute the geocentric position of the Moon
+//! \param jd - The Julian day number (TT)
+//! \param [out] v - The geocentric position of the Moon, in J2000 equatorial coordinates (AU)
+
+static void moon_geocentric(double jd, double *v) {
+    const double t = (jd - EPHEMERIS_JD_J2000) / 36525;
+    const double deg = M_PI / 180;
+
+    // Fundamental arguments (degrees)
+    const double lp = 218.3164477 + 481267.88123421 * t - 0.0015786 * t * t + t * t * t / 538841;
+    const double d = 297.8501921 + 445267.1114034 * t - 0.0018819 * t * t + t * t * t / 545868;
+    const double m = 357.5291092 + 35999.0502909 * t - 0.0001536 * t * t;
+    const double mp = 134.9633964 + 477198.8675055 * t + 0.0087414 * t * t + t * t * t / 69699;
+    const double f = 93.2720950 + 483202.0175233 * t - 0.0036539 * t * t - t * t * t / 3526000;
+    const double a1 = 119.75 + 131.849 * t;
+    const double a2 = 53.09 + 479264.290 * t;
+    const double a3 = 313.45 + 481266.484 * t;
+
+    // Terms involving the Sun's mean anomaly are scaled to allow for the decreasing eccentricity of the Earth's orbit
+    const double ecc = 1 - 0.002516 * t - 0.0000074 * t * t;
+
+    double sum_l = 0, sum_r = 0, sum_b = 0;
+    for (int i = 0; i < (int) (sizeof(moon_longitude_terms) / sizeof(moon_longitude_terms[0])); i++) {
+        const int *term = moon_longitude_terms[i];
+        const double arg = (term[0] * d + term[1] * m + term[2] * mp + term[3] * f) * deg;
+        const double scale = (abs(term[1]) == 1) ? ecc : ((abs(term[1]) == 2) ? ecc * ecc : 1);
+        sum_l += term[4] * scale * sin(arg);
+        sum_r += term[5] * scale * cos(arg);
+    }
+    for (int i = 0; i < (int) (sizeof(moon_latitude_terms) / sizeof(moon_latitude_terms[0])); i++) {
+        const int *term = moon_latitude_terms[i];
+        const double arg = (term[0] * d + term[1] * m + term[2] * mp + term[3] * f) * deg;
+        const double scale = (abs(term[1]) == 1) ? ecc : ((abs(term[1]) == 2) ? ecc * ecc : 1);
+        sum_b += term[4] * scale * sin(arg);
+    }
+
+    // Additive terms due to Venus, Jupiter and the flattening of the Earth
+    sum_l += 3958 * sin(a1 * deg) + 1962 * sin((lp - f) * deg) + 318 * sin(a2 * deg);
+    sum_b += (-2235 * sin(lp * deg) + 382 * sin(a3 * deg) + 175 * sin((a1 - f) * deg) + 175 * sin((a1 + f) * deg) +
+              127 * sin((lp - mp) * deg) - 115 * sin((lp + mp) * deg));
+
+    // Ecliptic coordinates are referred to the equinox of date, so remove the precession since J2000.0
+    const double longitude = (lp + sum_l / 1e6 - 1.396971 * t) * deg;
+    const double latitude = (sum_b / 1e6) * deg;
+    const double distance = (385000.56 + sum_r / 1000) / EPHEMERIS_AU_KM;
+
+    v[0] = distance * cos(latitude) * cos(longitude);
+    v[1] = distance * cos(latitude) * sin(longitude);
+    v[2] = distance * sin(latitude);
+    ecliptic_to_equatorial(v);
+}
+
+//! earth_heliocentric - Compute the heliocentric position of the Earth
+//! \param jd - The Julian day number (TT)
+//! \param [out] v - The heliocentric position of the Earth, in J2000 equatorial coordinates (AU)
+
+static void earth_heliocentric(double jd, double *v) {
+    double moon[3];
+    planet_heliocentric(EPHEMERIS_BODY_EARTH, jd, v);
+    moon_geocentric(jd, moon);
+    for (int j = 0; j < 3; j++) v[j] -= moon[j] / (1 + EPHEMERIS_EARTH_MOON_MASS_RATIO);
+}
+
+//! body_magnitude - Estimate the visual magnitude of a body, using the expressions of Meeus, chapter 41
+//! \param body - One of the EPHEMERIS_BODY_* constants
+//! \param r - Distance of the body from the Sun (AU)
+//! \param delta - Distance of the body from the Earth (AU)
+//! \param phase_angle - The angle Sun-body-Earth (degrees)
+//! \param ring_tilt - For Saturn, the sine of the tilt of the rings towards the Earth
+//! \return - The visual magnitude of the body
+
+static double body_magnitude(int body, double r, double delta, double phase_angle, double ring_tilt) {
+    const double i = phase_angle;
+    const double distance_term = 5 * log10(r * delta);
+    switch (body) {
+        case EPHEMERIS_BODY_SUN:
+            return -26.74 + 5 * log10(delta);
+        case EPHEMERIS_BODY_MERCURY:
+            return -0.42 + distance_term + 0.0380 * i - 0.000273 * i * i + 0.000002 * i * i * i;
+        case EPHEMERIS_BODY_VENUS:
+            return -4.40 + distance_term + 0.0009 * i + 0.000239 * i * i - 0.00000065 * i * i * i;
+        case EPHEMERIS_BODY_MARS:
+            return -1.52 + distance_term + 0.016 * i;
+        case EPHEMERIS_BODY_JUPITER:
+            return -9.40 + distance_term + 0.005 * i;
+        case EPHEMERIS_BODY_SATURN:
+            return -8.88 + distance_term + 0.044 * i - 2.60 * fabs(ring_tilt) + 1.25 * gsl_pow_2(ring_tilt);
+        case EPHEMERIS_BODY_URANUS:
+            return -7.19 + distance_term;
+        case EPHEMERIS_BODY_NEPTUNE:
+            return -6.87 + distance_term;
+        case EPHEMERIS_BODY_PLUTO:
+            return -1.00 + distance_term;
+        case EPHEMERIS_BODY_MOON:
+            return -12.73 + 0.026 * i + 4e-9 * gsl_pow_4(i) + 5 * log10(delta * EPHEMERIS_AU_KM / 384400);
+        default:
+            return GSL_NAN;
+    }
+}
+
+//! ephemeris_engine_compute - Compute the position, brightness, phase and angular size of a body at a given time
+//! \param body - One of the EPHEMERIS_BODY_* constants
+//! \param jd - The Julian day number (TT)
+//! \param [out] output - The ephemeris data point to populate. The text label fields are cleared.
+
+void ephemeris_engine_compute(int body, double jd, ephemeris_point *output) {
+    double earth[3], position[3], geocentric[3];
+    earth_heliocentric(jd, earth);
+
+    if (body == EPHEMERIS_BODY_MOON) {
+        moon_geocentric(jd, geocentric);
+        for (int j = 0; j < 3; j++) position[j] = earth[j] + geocentric[j];
+    } else if (body == EPHEMERIS_BODY_SUN) {
+        for (int j = 0; j < 3; j++) position[j] = 0;
+        for (int j = 0; j < 3; j++) geocentric[j] = -earth[j];
+    } else {
+        // Iterate to allow for the time taken for light to travel from the planet to the Earth
+        double light_time = 0;
+        for (int iteration = 0; iteration < 3; iteration++) {
+            planet_heliocentric(body, jd - light_time, position);
+            for (int j = 0; j < 3; j++) geocentric[j] = position[j] - earth[j];
+            light_time = gsl_hypot3(geocentric[0], geocentric[1], geocentric[2]) * EPHEMERIS_LIGHT_TIME_PER_AU;
+        }
+    }
+
+    const double delta = gsl_hypot3(geocentric[0], geocentric[1], geocentric[2]);
+    const double r = gsl_hypot3(position[0], position[1], position[2]);
+
+    // The phase angle is the angle Sun-body-Earth
+    double phase_angle = 0;
+    if (body != EPHEMERIS_BODY_SUN) {
+        const double cos_phase = ((position[0] * geocentric[0] + position[1] * geocentric[1] +
+                                   position[2] * geocentric[2]) / (r * delta));
+        phase_angle = acos(gsl_max(-1, gsl_min(1, cos_phase)));
+    }
+
+    output->jd = jd;
+    output->ra = atan2(geocentric[1], geocentric[0]);
+    if (output->ra < 0) output->ra += 2 * M_PI;
+    output->dec = asin(geocentric[2] / delta);
+    // Saturn's brightness depends on how far its rings are tilted towards us
+    double ring_tilt = 0;
+    if (body == EPHEMERIS_BODY_SATURN) {
+        ring_tilt = (cos(EPHEMERIS_SATURN_POLE_DEC) * cos(EPHEMERIS_SATURN_POLE_RA) * geocentric[0] +
+                     cos(EPHEMERIS_SATURN_POLE_DEC) * sin(EPHEMERIS_SATURN_POLE_RA) * geocentric[1] +
+                     sin(EPHEMERIS_SATURN_POLE_DEC) * geocentric[2]) / delta;
+    }
+
+    output->mag = body_magnitude(body, r, delta, phase_angle * 180 / M_PI, ring_tilt);
+    output->phase = (1 + cos(phase_angle)) / 2;
+    output->angular_size = 2 * atan(body_radius[body] / (delta * EPHEMERIS_AU_KM)) * 180 / M_PI * 3600;
+    output->text_label = NULL;
+    output->sub_month_label = 0;
+}
@@ -0,0 +1,45 @@
+// ephemerisEngine.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef EPHEMERIS_ENGINE_H
+#define EPHEMERIS_ENGINE_H 1
+
+#include "settings/chart_config.h"
+
+//! The solar system bodies whose positions the built-in ephemeris engine can compute. The planets are numbered
+//! as in ephemerisCompute (p1 to p9).
+#define EPHEMERIS_BODY_SUN      0
+#define EPHEMERIS_BODY_MERCURY  1
+#define EPHEMERIS_BODY_VENUS    2
+#define EPHEMERIS_BODY_EARTH    3
+#define EPHEMERIS_BODY_MARS     4
+#define EPHEMERIS_BODY_JUPITER  5
+#define EPHEMERIS_BODY_SATURN   6
+#define EPHEMERIS_BODY_URANUS   7
+#define EPHEMERIS_BODY_NEPTUNE  8
+#define EPHEMERIS_BODY_PLUTO    9
+#define EPHEMERIS_BODY_MOON    10
+
+int ephemeris_engine_body_from_name(const char *object_id, double jd_start, double jd_end);
+
+void ephemeris_engine_compute(int body, double jd, ephemeris_point *output);
+
+#endif
@@ -29,6 +29,23 @@
 #include "mathsTools/sphericalTrig.h"
 #include "mathsTools/projection.h"
 
+//! field_of_view_radius - Work out the angular radius of a cap, centred on the centre of the chart, which encloses
+//! the whole of a chart with a zenithal projection. For other projections, the whole sky is returned.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \return - The angular radius of the cap (radians)
+
+double field_of_view_radius(const chart_config *s) {
+    // The projected radius increases monotonically with distance from the centre, so the corners are furthest away
+    const double r = gsl_max(hypot(s->x_min, s->y_min),
+                             gsl_max(hypot(s->x_min, s->y_max),
+                                     gsl_max(hypot(s->x_max, s->y_min), hypot(s->x_max, s->y_max))));
+
+    if (s->projection == SW_PROJECTION_GNOM) return atan(r);
+    if (s->projection == SW_PROJECTION_SPH) return (r >= 1) ? M_PI / 2 : asin(r);
+    if (s->projection == SW_PROJECTION_ALTAZ) return gsl_min(M_PI, r * s->angular_width / 2);
+    return M_PI;
+}
+
 //! galacticProject - Project a position on the sky from equatorial coordinates (RA, Dec) into galactic coordinates
 //! \param ra - The right ascension of the point to convert (radians)
 //! \param dec - The declination of the point to convert (radians)
@@ -24,6 +24,10 @@
 
 #include "settings/chart_config.h"
 
+double field_of_view_radius(const chart_config *s);
+
+void galactic_project(double ra, double dec, double *l_out, double *b_out);
+
 void plane_project(double *x, double *y, chart_config *s, double lng, double lat, int grid_line);
 
 void inv_plane_project(double *ra, double *dec, chart_config *s, double x, double y);
@@ -29,6 +29,7 @@
 
 #include "chart_config.h"
 
+#include "astroGraphics/constellationGeometry.h"
 #include "astroGraphics/stars.h"
 
 void default_config(chart_config *i) {
@@ -54,6 +55,8 @@ void default_config(chart_config *i) {
     i->messier_only = 0;
     i->plot_dso = 1;
     i->zodiacal_only = 0;
+    memset(i->constellation_selection, 0, sizeof(i->constellation_selection));
+    for (int j = 0; j < CONSTELLATION_COUNT; j++) CONSTELLATION_MASK_SET(i->constellation_selection, j);
     i->star_names = 1;
     i->star_catalogue_numbers = 0;
     i->star_catalogue = SW_CAT_HIP;
@@ -119,9 +122,17 @@ void default_config(chart_config *i) {
     i->label_font_size_scaling = 1;
     strcpy(i->constellation_highlight, "---");
     strcpy(i->ephemeris_compute_path, SRCDIR "../../ephemeris-compute-de430/bin/ephem.bin");
+    i->ephemeris_engine = SW_EPHEMERIS_COMPUTE;
+    strcpy(i->ephemeris_cache_dir, SRCDIR "../data/ephemerisCache");
     strcpy(i->galaxy_map_filename, SRCDIR "../data/milkyWay/process/output/galaxymap.dat");
     strcpy(i->photo_filename, "");
     strcpy(i->output_filename, "chart");
+    i->stdout_format = SW_FORMAT_PNG;
+    i->png_dpi = 100;
+    i->png_compression_level = 6;
+    i->png_band_height = 0;
+    i->svg_compact = 0;
+    i->line_simplification = 0.1;
     strcpy(i->copyright, "");
     strcpy(i->title, "");
 
@@ -130,10 +141,10 @@ void default_config(chart_config *i) {
     // ----------------------------------------
 
     strcpy(i->font_family, "Roboto");
-    i->great_circle_line_width = 1.75;
-    i->coordinate_grid_line_width = 1.3;
+    i->great_circle_line_width = 2.52;
+    i->coordinate_grid_line_width = 1.87;
     i->dso_point_size_scaling = 1;
-    i->constellation_sticks_line_width = 1.4;
+    i->constellation_sticks_line_width = 2.02;
     i->chart_edge_line_width = 2.5;
 }
 
@@ -158,6 +169,15 @@ void config_init(chart_config *i) {
     i->y_max = i->wlin / 2 * i->aspect;
     tweak_magnitude_limits(i);
     i->mag_highest = i->mag_max;
+
+    // Work out which constellations we are to draw, so that each constellation is tested with a single bit lookup
+    memcpy(i->constellation_mask, i->constellation_selection, sizeof(i->constellation_mask));
+    if (i->zodiacal_only) {
+        uint64_t zodiac[CONSTELLATION_MASK_WORDS];
+        constellation_mask_from_list("AQR,ARI,CNC,CAP,GEM,LEO,LIB,OPH,TAU,SGR,SCO,VIR,PSC", zodiac);
+        for (int j = 0; j < CONSTELLATION_MASK_WORDS; j++) i->constellation_mask[j] &= zodiac[j];
+    }
+    i->constellation_highlight_id = constellation_id_from_abbreviation(i->constellation_highlight);
 }
 
 void config_close(chart_config *i) {
@@ -22,9 +22,12 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H 1
 
+#include <stdint.h>
+
 #include <cairo/cairo.h>
 
 #include "coreUtils/strConstants.h"
+#include "vectorGraphics/svgWriter.h"
 
 // Options for projections to use to represent curved sky on a flat chart
 #define SW_PROJECTION_FLAT   1
@@ -43,6 +46,9 @@
 #define SW_FORMAT_EPS 3
 #define SW_FORMAT_PDF 4
 
+// Chart is drawn onto a cairo recording surface, which is replayed onto several output files
+#define SW_FORMAT_RECORDING 5
+
 // Options for catalogue to use when labelling the catalogue numbers of stars
 #define SW_CAT_HIP  1
 #define SW_CAT_YBSC 2
@@ -56,15 +62,35 @@
 #define SW_STICKS_SIMPLIFIED 0
 #define SW_STICKS_REY 1
 
+// Options for how we compute the paths of solar system objects
+#define SW_EPHEMERIS_BUILTIN 1
+#define SW_EPHEMERIS_COMPUTE 2
+
 //! The maximum number of text labels we can buffer
 #define MAX_LABELS 65536
 
+//! The maximum number of possible positions we can buffer for each text label
+#define MAX_LABEL_POSITIONS 4
+
+//! The number of bytes of storage available for the strings of buffered text labels
+#define LABEL_STRING_STORE_SIZE 1048576
+
 //! The maximum number of exclusion regions we can buffer
 #define MAX_EXCLUSION_REGIONS 65536
 
 //! The maximum number of objects we're allowed to draw ephemeris lines for on a single chart
 #define N_TRACES_MAX 32
 
+//! The maximum number of output files we can render a single chart into
+#define N_OUTPUTS_MAX 8
+
+//! The number of 64-bit words in a bit mask with one bit for each of the 88 constellations
+#define CONSTELLATION_MASK_WORDS 2
+
+//! Test and set the bits for individual constellations, indexed by numeric id, in a constellation bit mask
+#define CONSTELLATION_MASK_TEST(mask, id) (((mask)[(id) >> 6] >> ((id) & 63)) & 1)
+#define CONSTELLATION_MASK_SET(mask, id) ((mask)[(id) >> 6] |= ((uint64_t) 1) << ((id) & 63))
+
 //! Define an RGB colour to use to draw a particular item on a chart
 typedef struct colour {
     double red, grn, blu;
@@ -85,8 +111,11 @@ typedef struct ephemeris_point {
 typedef struct ephemeris {
     double jd_start, jd_end, jd_step; // Julian day numbers
     double maximum_angular_size, minimum_phase, brightest_magnitude;
+    int engine_body; // The body number used by the built-in ephemeris engine, or -1 if computed by ephemerisCompute
     int point_count;
     ephemeris_point *data;
+    int track_point_count;
+    ephemeris_point *track; // Adaptively-sampled points used to draw the track on the chart
 } ephemeris;
 
 typedef struct chart_config {
@@ -137,6 +166,17 @@ typedef struct chart_config {
     //! Optionally select a constellation to highlight
     char constellation_highlight[8];
 
+    //! The numeric id of the constellation to highlight, or -1 for none. Computed by config_init.
+    int constellation_highlight_id;
+
+    //! Bit mask of the constellations selected by the <constellations> setting, indexed by constellation id
+    uint64_t constellation_selection[CONSTELLATION_MASK_WORDS];
+
+    //! Bit mask of the constellations which we draw, combining <constellation_selection> with <zodiacal_only>.
+    //! Computed once per chart by config_init, so that each piece of constellation geometry is tested with a
+    //! single bit lookup.
+    uint64_t constellation_mask[CONSTELLATION_MASK_WORDS];
+
     //! Boolean indicating whether we label the English names of stars
     int star_names;
 
@@ -274,9 +314,40 @@ typedef struct chart_config {
     //! See <https://github.com/dcf21/ephemeris-compute-de430>
     char ephemeris_compute_path[FNAME_LENGTH];
 
+    //! Select how we compute the paths of solar system objects. Either SW_EPHEMERIS_COMPUTE (the default), which uses
+    //! <ephemerisCompute> for all objects, or SW_EPHEMERIS_BUILTIN, which uses the less accurate built-in ephemeris
+    //! engine for the Sun, Moon and planets between 1800 and 2050, and <ephemerisCompute> for other objects.
+    int ephemeris_engine;
+
+    //! The directory in which to cache ephemerides computed by <ephemerisCompute>, so that they do not need to be
+    //! recomputed when a chart is redrawn. If empty, ephemerides are not cached.
+    char ephemeris_cache_dir[FNAME_LENGTH];
+
     //! The target filename for the star chart. The file type (svg, png, eps or pdf) is inferred from the file extension.
+    //! A comma-separated list of filenames may be given, in which case the chart is drawn once and then written to
+    //! each of the files. A filename of "-" means the chart is written to stdout.
     char output_filename[FNAME_LENGTH];
 
+    //! The image format to use for output written to stdout. One of SW_FORMAT_SVG, SW_FORMAT_PNG, SW_FORMAT_EPS or
+    //! SW_FORMAT_PDF.
+    int stdout_format;
+
+    //! The resolution of PNG output, in pixels per inch. This scales the output image without changing its layout.
+    double png_dpi;
+
+    //! The zlib compression level to use when writing PNG files, from 0 (fastest) to 9 (smallest)
+    int png_compression_level;
+
+    //! If greater than zero, PNG files are rendered in horizontal bands of this many pixels, to limit memory usage
+    int png_band_height;
+
+    //! Boolean flag indicating whether SVG files are written with our own compact SVG writer, which writes stars as
+    //! reusable symbols and text as <text> elements, rather than as cairo paths and glyph outlines
+    int svg_compact;
+
+    //! The maximum distance, in device pixels, by which lines may be simplified by merging nearly-collinear segments
+    double line_simplification;
+
     //! The copyright string to write under the star chart
     char copyright[FNAME_LENGTH];
 
@@ -389,16 +460,17 @@ typedef struct chart_config {
     //! The font family we should use for text output
     char font_family[64];
 
-    //! The line width to use when tracing great circles
+    //! The line width to use when tracing great circles, as a multiple of <line_width_base>
     double great_circle_line_width;
 
-    //! The line width to use when plotting the coordinate grid in the background of the star chart
+    //! The line width to use when plotting the coordinate grid in the background of the star chart, as a multiple of
+    //! <line_width_base>
     double coordinate_grid_line_width;
 
     //! Scaling factor to apply to the point size used to represent deep sky objects
     double dso_point_size_scaling;
 
-    //! Line width to use for constellation stick figures
+    //! Line width to use for constellation stick figures, as a multiple of <line_width_base>
     double constellation_sticks_line_width;
 
     //! Line width to use for the edge of the star chart
@@ -411,10 +483,23 @@ typedef struct chart_config {
     //! Ephemeris data for solar system objects
     ephemeris *ephemeris_data;
 
-    //! Image format to use for the output. One of SW_FORMAT_SVG, SW_FORMAT_PNG, SW_FORMAT_EPS or SW_FORMAT_PDF
+    //! Image format of the surface we draw onto. One of SW_FORMAT_SVG, SW_FORMAT_PNG, SW_FORMAT_EPS,
+    //! SW_FORMAT_PDF or SW_FORMAT_RECORDING
     int output_format;
 
+    //! The number of output files listed in <output_filename>
+    int output_count;
+
+    //! The filenames of each of the output files listed in <output_filename>
+    char output_filenames[N_OUTPUTS_MAX][FNAME_LENGTH];
+
+    //! The image format of each of the output files listed in <output_filename>
+    int output_formats[N_OUTPUTS_MAX];
+
     double canvas_width, canvas_height, canvas_offset_x, canvas_offset_y, dpi, pt, cm, mm, line_width_base;
+
+    //! The resolution of the highest-resolution output file we are producing, in pixels per inch
+    double raster_dpi;
     double wlin, marg, x_min, x_max, y_min, y_max;
 
     //! Width of the right-hand column of the legend under the finder chart
@@ -426,6 +511,9 @@ typedef struct chart_config {
     //! Cairo drawing context
     cairo_t *cairo_draw;
 
+    //! Layer of native SVG primitives which stars and text are drawn onto when writing compact SVG output, or NULL
+    svg_layer *svg_layer;
+
 } chart_config;
 
 void default_config(chart_config *i);
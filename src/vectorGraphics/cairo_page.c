@@ -42,6 +42,8 @@
 #include "settings/chart_config.h"
 
 #include "vectorGraphics/cairo_page.h"
+#include "vectorGraphics/pngWriter.h"
+#include "vectorGraphics/svgWriter.h"
 
 //! One quarter-turn in radians
 #define DEG90  (90.*M_PI/180.)
@@ -52,6 +54,9 @@
 //! One three-quarter-turn in radians
 #define DEG270  (270.*M_PI/180.)
 
+//! The resolution of vector graphics output, in points per inch
+#define VECTOR_DPI 72
+
 
 //! string_make_permanent - Copy a string into a new malloced buffer
 //! \param in - The input string to copy
@@ -67,37 +72,221 @@ char *string_make_permanent(const char *in) {
     return out;
 }
 
+//! write_to_stream - Callback used by cairo to write the bytes of an output file to a stdio stream
+//! \param closure - The FILE pointer of the stream to write to
+//! \param data - The bytes to write
+//! \param length - The number of bytes to write
+//! \return - Cairo status code
+
+static cairo_status_t write_to_stream(void *closure, const unsigned char *data, unsigned int length) {
+    FILE *stream = (FILE *) closure;
+    if (fwrite(data, 1, length, stream) != length) return CAIRO_STATUS_WRITE_ERROR;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+//! output_is_stdout - Test whether an output filename indicates that the chart should be written to stdout
+//! \param filename - The filename of the output file
+//! \return - Boolean flag indicating whether the output should be written to stdout
+
+static int output_is_stdout(const char *filename) {
+    return strcmp(filename, "-") == 0;
+}
+
+//! output_format_from_filename - Work out what graphics format we are producing from the extension of a filename
+//! \param filename - The filename of the output file
+//! \return - One of SW_FORMAT_SVG, SW_FORMAT_PNG, SW_FORMAT_EPS or SW_FORMAT_PDF
+
+static int output_format_from_filename(const char *filename) {
+    const int filename_len = (int) strlen(filename);
+    const int filename_extension_start = (int) gsl_max(filename_len - 3, 0);
+
+    if (str_cmp_no_case(filename + filename_extension_start, "svg") == 0) {
+        return SW_FORMAT_SVG;
+    } else if (str_cmp_no_case(filename + filename_extension_start, "png") == 0) {
+        return SW_FORMAT_PNG;
+    } else if (str_cmp_no_case(filename + filename_extension_start, "eps") == 0) {
+        return SW_FORMAT_EPS;
+    } else if (str_cmp_no_case(filename + filename_extension_start, "pdf") == 0) {
+        return SW_FORMAT_PDF;
+    }
+
+    stch_fatal(__FILE__, __LINE__, "Could not determine output format from file extension.");
+    exit(1);
+}
+
+//! output_format_dpi - Return the resolution at which we render a particular graphics format
+//! \param s - Settings for the star chart we are drawing
+//! \param format - One of SW_FORMAT_SVG, SW_FORMAT_PNG, SW_FORMAT_EPS, SW_FORMAT_PDF or SW_FORMAT_RECORDING
+//! \return - The number of cairo units per inch
+
+static double output_format_dpi(const chart_config *s, int format) {
+    return (format == SW_FORMAT_PNG) ? s->png_dpi : VECTOR_DPI;
+}
+
+//! create_output_surface - Create a cairo surface which will be written to an output file
+//! \param filename - The filename of the output file
+//! \param format - The graphics format of the output file
+//! \param width - The width of the surface (cairo units)
+//! \param height - The height of the surface (cairo units)
+//! \return - The new cairo surface
+
+static cairo_surface_t *create_output_surface(const char *filename, int format, double width, double height) {
+    cairo_surface_t *surface = NULL;
+    const int to_stdout = output_is_stdout(filename);
+
+    // Create cairo drawing surface of the appropriate graphics type
+    switch (format) {
+        case SW_FORMAT_SVG:
+            if (to_stdout) surface = cairo_svg_surface_create_for_stream(write_to_stream, stdout, width, height);
+            else surface = cairo_svg_surface_create(filename, width, height);
+            break;
+        case SW_FORMAT_PNG:
+            surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int) width, (int) height);
+            break;
+        case SW_FORMAT_EPS:
+            if (to_stdout) surface = cairo_ps_surface_create_for_stream(write_to_stream, stdout, width, height);
+            else surface = cairo_ps_surface_create(filename, width, height);
+            cairo_ps_surface_set_eps(surface, 1);
+            break;
+        case SW_FORMAT_PDF:
+            if (to_stdout) surface = cairo_pdf_surface_create_for_stream(write_to_stream, stdout, width, height);
+            else surface = cairo_pdf_surface_create(filename, width, height);
+            break;
+        case SW_FORMAT_RECORDING:
+            surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA,
+                                                     &(cairo_rectangle_t) {0, 0, width, height});
+            break;
+        default:
+            stch_fatal(__FILE__, __LINE__, "Unrecognised output format.");
+            exit(1);
+    }
+
+    // Check that surface was created
+    int cairo_status = cairo_surface_status(surface);
+    if (cairo_status != 0) {
+        snprintf(temp_err_string, 4096, "Could not create output file. Error was: %s.",
+                 cairo_status_to_string(cairo_status));
+        stch_fatal(__FILE__, __LINE__, temp_err_string);
+        exit(1);
+    }
+
+    return surface;
+}
+
+//! open_output_stream - Open the stream that an output file we encode ourselves is to be written to
+//! \param filename - The filename of the output file, or "-" for stdout
+//! \return - The stream to write to
+
+static FILE *open_output_stream(const char *filename) {
+    FILE *output = output_is_stdout(filename) ? stdout : fopen(filename, "wb");
+    if (output == NULL) {
+        snprintf(temp_err_string, 4096, "Could not create output file <%s>.", filename);
+        stch_fatal(__FILE__, __LINE__, temp_err_string);
+        exit(1);
+    }
+    return output;
+}
+
+//! close_output_stream - Close the stream that an output file has been written to
+//! \param output - The stream to close
+
+static void close_output_stream(FILE *output) {
+    if (output == stdout) fflush(stdout);
+    else fclose(output);
+}
+
+//! close_output_surface - Write a completed cairo surface to its output file, and then destroy it
+//! \param s - Settings for the star chart we are drawing
+//! \param surface - The cairo surface to close
+//! \param filename - The filename of the output file
+//! \param format - The graphics format of the output file
+
+static void close_output_surface(const chart_config *s, cairo_surface_t *surface, const char *filename, int format) {
+    if (format == SW_FORMAT_PNG) {
+        // Check that surface is OK
+        int cairo_status = cairo_surface_status(surface);
+        if (cairo_status != 0) {
+            snprintf(temp_err_string, 4096, "Could not create output file. Error was: %s.",
+                     cairo_status_to_string(cairo_status));
+            stch_fatal(__FILE__, __LINE__, temp_err_string);
+            exit(1);
+        }
+
+        // Encode the pixel data using our own multi-threaded PNG writer
+        FILE *output = open_output_stream(filename);
+        cairo_surface_flush(surface);
+        png_write_argb32(output,
+                         cairo_image_surface_get_data(surface),
+                         cairo_image_surface_get_width(surface),
+                         cairo_image_surface_get_height(surface),
+                         cairo_image_surface_get_stride(surface),
+                         s->png_compression_level, s->png_dpi);
+        close_output_stream(output);
+    }
+
+    cairo_surface_finish(surface);
+    cairo_surface_destroy(surface);
+    if (output_is_stdout(filename)) fflush(stdout);
+}
+
 //! cairo_init - Initialise a cairo drawing surface to render a star chart onto
 //! \param p - A structure describing the status of the drawing surface
 //! \param s - Settings for the star chart we are to draw
 
 void cairo_init(cairo_page *p, chart_config *s) {
 
-    // Work out what graphics format we are producing from the extension of <s->output_filename>
-    const int filename_len = (int) strlen(s->output_filename);
-    const int filename_extension_start = (int) gsl_max(filename_len - 3, 0);
+    // <s->output_filename> may contain a comma-separated list of output files
+    const char *filename_scan = s->output_filename;
+    s->output_count = 0;
+    while (*filename_scan != '\0') {
+        if (s->output_count >= N_OUTPUTS_MAX) {
+            stch_fatal(__FILE__, __LINE__, "Too many output files specified for a single chart.");
+        }
+        char *filename = s->output_filenames[s->output_count];
+        str_comma_separated_list_scan(&filename_scan, filename);
+        if (filename[0] == '\0') continue;
+
+        // Work out what graphics format we are producing from the extension of each filename
+        if (output_is_stdout(filename)) s->output_formats[s->output_count] = s->stdout_format;
+        else s->output_formats[s->output_count] = output_format_from_filename(filename);
+        s->output_count++;
+    }
+    if (s->output_count < 1) {
+        stch_fatal(__FILE__, __LINE__, "No output filename specified.");
+    }
 
-    if (str_cmp_no_case(s->output_filename + filename_extension_start, "svg") == 0) {
-        s->output_format = SW_FORMAT_SVG;
-    } else if (str_cmp_no_case(s->output_filename + filename_extension_start, "png") == 0) {
-        s->output_format = SW_FORMAT_PNG;
-    } else if (str_cmp_no_case(s->output_filename + filename_extension_start, "eps") == 0) {
-        s->output_format = SW_FORMAT_EPS;
-    } else if (str_cmp_no_case(s->output_filename + filename_extension_start, "pdf") == 0) {
-        s->output_format = SW_FORMAT_PDF;
-    } else {
-        stch_fatal(__FILE__, __LINE__, "Could not determine output format from file extension.");
+    // If we are producing more than one output file, we draw the chart once onto a recording surface, and then
+    // replay it onto each of the output files. We also do this if PNG output is to be rendered in horizontal bands.
+    const int banded_png = (s->png_band_height > 0) && (s->output_formats[0] == SW_FORMAT_PNG);
+    s->output_format = ((s->output_count > 1) || banded_png) ? SW_FORMAT_RECORDING : s->output_formats[0];
+
+    // If we are writing compact SVG, stars and text are drawn onto a layer of native SVG primitives, and everything
+    // else onto a recording surface. The recording is cut into segments wherever the two interleave, so that they can
+    // later be spliced together in the order in which they were drawn
+    s->svg_layer = NULL;
+    if (s->svg_compact) {
+        for (int i = 0; i < s->output_count; i++) {
+            if (s->output_formats[i] == SW_FORMAT_SVG) {
+                s->output_format = SW_FORMAT_RECORDING;
+                s->svg_layer = svg_layer_create();
+                break;
+            }
+        }
     }
 
     // Some useful units of size / width
-    const double png_dpi = 100;
-    const double vector_dpi = 72;
-    s->dpi = (s->output_format == SW_FORMAT_PNG) ? png_dpi : vector_dpi;  // pixels / inch
+    s->dpi = output_format_dpi(s, s->output_format);  // pixels / inch
     s->pt = s->dpi / 72;  // pixels / pt
     s->cm = 0.393701 * s->dpi;  // pixels / cm
     s->mm = s->cm * 0.1;  // pixels / mm
     s->line_width_base = 0.5 * s->pt; // standard line width
 
+    // The resolution of the finest output we are producing, which rasterised elements need to match
+    s->raster_dpi = s->dpi;
+    for (int i = 0; i < s->output_count; i++) {
+        s->raster_dpi = gsl_max(s->raster_dpi, output_format_dpi(s, s->output_formats[i]));
+    }
+
     // Work out the bounding box of the canvas to draw the star chart onto
     const int have_title = strcmp(s->title, "") != 0;
     s->canvas_offset_x = 1.6;
@@ -145,32 +334,8 @@ void cairo_init(cairo_page *p, chart_config *s) {
     s->legend_right_column_width = legend_right_width;
 
     // Create cairo drawing surface of the appropriate graphics type
-    switch (s->output_format) {
-        case SW_FORMAT_SVG:
-            s->cairo_surface = cairo_svg_surface_create(s->output_filename, s->canvas_width, s->canvas_height);
-            break;
-        case SW_FORMAT_PNG:
-            s->cairo_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-                                                          (int) s->canvas_width,
-                                                          (int) s->canvas_height);
-            break;
-        case SW_FORMAT_EPS:
-            s->cairo_surface = cairo_ps_surface_create(s->output_filename, s->canvas_width, s->canvas_height);
-            cairo_ps_surface_set_eps(s->cairo_surface, 1);
-            break;
-        case SW_FORMAT_PDF:
-            s->cairo_surface = cairo_pdf_surface_create(s->output_filename, s->canvas_width, s->canvas_height);
-            break;
-    }
-
-    // Check that surface was created
-    int cairo_status = cairo_surface_status(s->cairo_surface);
-    if (cairo_status != 0) {
-        snprintf(temp_err_string, 4096, "Could not create output file. Error was: %s.",
-                 cairo_status_to_string(cairo_status));
-        stch_fatal(__FILE__, __LINE__, temp_err_string);
-        exit(1);
-    }
+    s->cairo_surface = create_output_surface(s->output_filenames[0], s->output_format,
+                                             s->canvas_width, s->canvas_height);
 
     // Initialise empty lists of labels we will put on the edges of the star chart
     p->x_labels = listInit();
@@ -185,13 +350,20 @@ void cairo_init(cairo_page *p, chart_config *s) {
     p->labels_buffer = (label_buffer_item *) lt_malloc(MAX_LABELS * sizeof(label_buffer_item));
     p->labels_buffer_counter = 0;
 
+    // The strings of buffered labels are packed end-to-end into a single block of storage, so that buffering a
+    // label does not require a memory allocation
+    p->label_string_store = (char *) lt_malloc(LABEL_STRING_STORE_SIZE);
+    p->label_string_store_used = 0;
+
     // A list of the rectangular outlines of all the labels we've already written, such that no future labels are
     // allowed in these regions.
     p->exclusion_regions = (exclusion_region *) lt_malloc(MAX_EXCLUSION_REGIONS * sizeof(exclusion_region));
     p->exclusion_region_counter = 0;
 
-    // Create a cairo drawing context
-    s->cairo_draw = cairo_create(s->cairo_surface);
+    // Create a cairo drawing context. If we have a layer of native SVG primitives, it needs to observe what is drawn
+    // onto the recording surface.
+    if (s->svg_layer != NULL) s->cairo_draw = cairo_create(svg_layer_attach(s->svg_layer, s->cairo_surface));
+    else s->cairo_draw = cairo_create(s->cairo_surface);
     cairo_set_source_rgb(s->cairo_draw, 0, 0, 0);
 
     // While we're drawing the star chart, clip graphics operations to the plot area. This prevents text labels
@@ -213,6 +385,22 @@ void cairo_init(cairo_page *p, chart_config *s) {
     }
 
     cairo_clip(s->cairo_draw);
+
+    // Items drawn onto the native SVG layer are clipped to the same region
+    if (s->svg_layer != NULL) {
+        svg_layer *layer = s->svg_layer;
+        layer->clip_active = 1;
+        if ((s->projection == SW_PROJECTION_SPH) || (s->projection == SW_PROJECTION_ALTAZ)) {
+            layer->clip_x = (s->canvas_offset_x + s->width / 2) * s->cm;
+            layer->clip_y = (s->canvas_offset_y + s->width / 2 * s->aspect) * s->cm;
+            layer->clip_radius = s->width * s->cm / s->wlin;
+        } else {
+            layer->clip_x = s->canvas_offset_x * s->cm;
+            layer->clip_y = s->canvas_offset_y * s->cm;
+            layer->clip_width = s->width * s->cm;
+            layer->clip_height = s->width * s->aspect * s->cm;
+        }
+    }
 }
 
 //! plot_background_image - Render a PNG image in the background behind a star chart
@@ -248,6 +436,7 @@ void plot_background_image(chart_config *s) {
 
     // Destroy surface we created
     cairo_surface_finish(surface);
+    cairo_surface_destroy(surface);
 }
 
 //! draw_chart_edging - Draw the lines and labels around the edge of the star chart. First, we stop clipping the
@@ -260,6 +449,7 @@ void draw_chart_edging(cairo_page *p, chart_config *s) {
 
     // Stop clipping to the plot area
     cairo_restore(s->cairo_draw);
+    if (s->svg_layer != NULL) s->svg_layer->clip_active = 0;
 
     // Select a font
     cairo_select_font_face(s->cairo_draw, s->font_family, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
@@ -270,7 +460,7 @@ void draw_chart_edging(cairo_page *p, chart_config *s) {
     cairo_move_to(s->cairo_draw,
                   s->canvas_width / 2 - (extents.width / 2 + extents.x_bearing),
                   s->canvas_offset_y * s->cm * 0.32 - (extents.height / 2 + extents.y_bearing));
-    cairo_show_text(s->cairo_draw, s->title);
+    chart_show_text(s, s->title);
 
     // Draw outline of chart
     cairo_set_source_rgb(s->cairo_draw, 0, 0, 0);
@@ -323,7 +513,7 @@ void draw_chart_edging(cairo_page *p, chart_config *s) {
                           (s->canvas_offset_y * 1.6 + s->width * s->aspect) * s->cm
                           - (extents.height / 2 + extents.y_bearing)
             );
-            cairo_show_text(s->cairo_draw, x_label);
+            chart_show_text(s, x_label);
 
             const char *y_label = "Declination";
             cairo_text_extents(s->cairo_draw, y_label, &extents);
@@ -337,12 +527,46 @@ void draw_chart_edging(cairo_page *p, chart_config *s) {
                           -(extents.width / 2 + extents.x_bearing),
                           -(extents.height / 2 + extents.y_bearing)
             );
-            cairo_show_text(s->cairo_draw, y_label);
+            chart_show_text(s, y_label);
             cairo_restore(s->cairo_draw);
         }
     }
 }
 
+//! chart_show_text - Write a text string at the current point, in place of calling <cairo_show_text>. If we are
+//! writing compact SVG output, the text is drawn onto the native SVG layer rather than being rendered by cairo.
+//! \param s - Settings for the star chart we are drawing
+//! \param text - The string to write
+
+void chart_show_text(chart_config *s, const char *text) {
+    if (s->svg_layer != NULL) svg_layer_text(s->svg_layer, s->cairo_draw, text);
+    else cairo_show_text(s->cairo_draw, text);
+}
+
+//! chart_clip_contains_box - Test whether a rectangle lies entirely inside the plot area, to which graphics
+//! operations are clipped while the star chart is being drawn
+//! \param s - Settings for the star chart we are drawing
+//! \param x_min - The left edge of the rectangle (cairo coordinates)
+//! \param x_max - The right edge of the rectangle (cairo coordinates)
+//! \param y_min - The top edge of the rectangle (cairo coordinates)
+//! \param y_max - The bottom edge of the rectangle (cairo coordinates)
+//! \return - One if the rectangle lies entirely inside the clip region; zero otherwise
+
+int chart_clip_contains_box(const chart_config *s, double x_min, double x_max, double y_min, double y_max) {
+    if ((s->projection == SW_PROJECTION_SPH) || (s->projection == SW_PROJECTION_ALTAZ)) {
+        // The clip region is a circle, so the rectangle is inside it if all four corners are
+        const double x_centre = (s->canvas_offset_x + s->width / 2) * s->cm;
+        const double y_centre = (s->canvas_offset_y + s->width / 2 * s->aspect) * s->cm;
+        const double radius = s->width * s->cm / s->wlin;
+        const double dx = gsl_max(fabs(x_min - x_centre), fabs(x_max - x_centre));
+        const double dy = gsl_max(fabs(y_min - y_centre), fabs(y_max - y_centre));
+        return (dx * dx + dy * dy) <= radius * radius;
+    }
+
+    return (x_min >= s->canvas_offset_x * s->cm) && (x_max <= (s->canvas_offset_x + s->width) * s->cm) &&
+           (y_min >= s->canvas_offset_y * s->cm) && (y_max <= (s->canvas_offset_y + s->width * s->aspect) * s->cm);
+}
+
 //! fetch_canvas_coordinates - Convert the point (x_in, y_in) in "star chart" coordinates, into physical coordinates
 //! on the cairo page.
 //! \param [out] x_out - The physical x coordinate (cairo coordinates)
@@ -392,34 +616,41 @@ void chart_label_buffer(cairo_page *p, chart_config *s, colour colour, const cha
                         const label_position *possible_positions, int possible_position_count, int multiple_labels,
                         int make_background, double font_size, int font_bold, int font_italic, double extra_margin,
                         double priority) {
-    p->labels_buffer[p->labels_buffer_counter].s = s;
-    p->labels_buffer[p->labels_buffer_counter].colour = colour;
-    p->labels_buffer[p->labels_buffer_counter].label = string_make_permanent(label);
-
-    // Copy list of possible positions
-    p->labels_buffer[p->labels_buffer_counter].possible_position_count = possible_position_count;
-
-    p->labels_buffer[p->labels_buffer_counter].possible_positions = lt_malloc(
-            possible_position_count * sizeof(label_position)
-    );
-    memcpy(p->labels_buffer[p->labels_buffer_counter].possible_positions,
-           possible_positions,
-           possible_position_count * sizeof(label_position)
-    );
-
-    p->labels_buffer[p->labels_buffer_counter].multiple_labels = multiple_labels;
-    p->labels_buffer[p->labels_buffer_counter].make_background = make_background;
-    p->labels_buffer[p->labels_buffer_counter].font_size = font_size;
-    p->labels_buffer[p->labels_buffer_counter].font_bold = font_bold;
-    p->labels_buffer[p->labels_buffer_counter].font_italic = font_italic;
-    p->labels_buffer[p->labels_buffer_counter].extra_margin = extra_margin;
-    p->labels_buffer[p->labels_buffer_counter].priority = priority;
-    p->labels_buffer_counter++;
+    label_buffer_item *item = &p->labels_buffer[p->labels_buffer_counter];
 
     // Check for buffer overrun
-    if (p->labels_buffer_counter > MAX_LABELS) {
+    if (p->labels_buffer_counter >= MAX_LABELS) {
         stch_fatal(__FILE__, __LINE__, "Exceeded maximum number of text labels");
     }
+    if (possible_position_count > MAX_LABEL_POSITIONS) {
+        stch_fatal(__FILE__, __LINE__, "Exceeded maximum number of possible positions for a text label");
+    }
+
+    // Copy the label string into the label string store
+    const int label_length = (int) strlen(label);
+    if (p->label_string_store_used + label_length + 1 > LABEL_STRING_STORE_SIZE) {
+        stch_fatal(__FILE__, __LINE__, "Exceeded storage space for text labels");
+    }
+    char *label_copy = p->label_string_store + p->label_string_store_used;
+    memcpy(label_copy, label, label_length + 1);
+    p->label_string_store_used += label_length + 1;
+
+    item->s = s;
+    item->colour = colour;
+    item->label = label_copy;
+
+    // Copy list of possible positions
+    item->possible_position_count = possible_position_count;
+    memcpy(item->possible_positions, possible_positions, possible_position_count * sizeof(label_position));
+
+    item->multiple_labels = multiple_labels;
+    item->make_background = make_background;
+    item->font_size = font_size;
+    item->font_bold = font_bold;
+    item->font_italic = font_italic;
+    item->extra_margin = extra_margin;
+    item->priority = priority;
+    p->labels_buffer_counter++;
 }
 
 //! chart_label_sorter - Sort all of the text labels which have been buffered via calls to <chart_label_buffer> into
@@ -451,8 +682,9 @@ void chart_label_unbuffer(cairo_page *p) {
                     x->extra_margin, x->priority);
     }
 
-    // Clear out label buffer
+    // Clear out label buffer, releasing the storage used by the label strings
     p->labels_buffer_counter = 0;
+    p->label_string_store_used = 0;
     p->exclusion_region_counter = 0;
 }
 
@@ -647,14 +879,14 @@ int chart_label(cairo_page *p, chart_config *s, colour colour, const char *label
             cairo_set_source_rgb(s->cairo_draw, s->galaxy_col0.red, s->galaxy_col0.grn, s->galaxy_col0.blu);
             for (theta = 0; theta < 359; theta += 30) {
                 cairo_move_to(s->cairo_draw, x_canvas + offset * sin(theta), y_canvas + offset * cos(theta));
-                cairo_show_text(s->cairo_draw, label);
+                chart_show_text(s, label);
             }
         }
 
         // Render the text label itself
         cairo_set_source_rgb(s->cairo_draw, colour.red, colour.grn, colour.blu);
         cairo_move_to(s->cairo_draw, x_canvas, y_canvas);
-        cairo_show_text(s->cairo_draw, label);
+        chart_show_text(s, label);
 
         return 0;
     }
@@ -713,7 +945,7 @@ void chart_ticks_draw(cairo_page *p, chart_config *s, list *labels, char *axis)
             cairo_translate(s->cairo_draw, x_canvas, y_canvas);
             cairo_rotate(s->cairo_draw, s->x_label_slant * M_PI / 180);
             cairo_move_to(s->cairo_draw, -extents.width / 2 - extents.x_bearing, -extents.y_bearing);
-            cairo_show_text(s->cairo_draw, tic_text);
+            chart_show_text(s, tic_text);
             cairo_restore(s->cairo_draw);
         } else if (strcmp(axis, "x2") == 0) {
             // Calculate coordinates of this label
@@ -733,7 +965,7 @@ void chart_ticks_draw(cairo_page *p, chart_config *s, list *labels, char *axis)
             cairo_translate(s->cairo_draw, x_canvas, y_canvas);
             cairo_rotate(s->cairo_draw, s->x_label_slant * M_PI / 180);
             cairo_move_to(s->cairo_draw, -extents.width / 2 - extents.x_bearing, -extents.height - extents.y_bearing);
-            cairo_show_text(s->cairo_draw, tic_text);
+            chart_show_text(s, tic_text);
             cairo_restore(s->cairo_draw);
         } else if (strcmp(axis, "y") == 0) {
             // Calculate coordinates of this label
@@ -754,7 +986,7 @@ void chart_ticks_draw(cairo_page *p, chart_config *s, list *labels, char *axis)
             cairo_translate(s->cairo_draw, x_canvas, y_canvas);
             cairo_rotate(s->cairo_draw, s->y_label_slant * M_PI / 180);
             cairo_move_to(s->cairo_draw, -extents.width - extents.x_bearing, -extents.height / 2 - extents.y_bearing);
-            cairo_show_text(s->cairo_draw, tic_text);
+            chart_show_text(s, tic_text);
             cairo_restore(s->cairo_draw);
         } else if (strcmp(axis, "y2") == 0) {
             // Calculate coordinates of this label
@@ -775,7 +1007,7 @@ void chart_ticks_draw(cairo_page *p, chart_config *s, list *labels, char *axis)
             cairo_translate(s->cairo_draw, x_canvas, y_canvas);
             cairo_rotate(s->cairo_draw, s->y_label_slant * M_PI / 180);
             cairo_move_to(s->cairo_draw, -extents.x_bearing, -extents.height / 2 - extents.y_bearing);
-            cairo_show_text(s->cairo_draw, tic_text);
+            chart_show_text(s, tic_text);
             cairo_restore(s->cairo_draw);
         } else if (strcmp(axis, "r") == 0) {
             // Calculate coordinates of this label
@@ -795,12 +1027,64 @@ void chart_ticks_draw(cairo_page *p, chart_config *s, list *labels, char *axis)
             cairo_translate(s->cairo_draw, x_canvas, y_canvas);
             cairo_move_to(s->cairo_draw, -extents.width / 2 -extents.x_bearing +(extents.width+0.5*s->cm)/2*cos(tic_pos),
 			    -extents.height/2 -extents.y_bearing +(extents.height+0.5*s->cm)/2*sin(tic_pos)); //radial align with 0.5cm margin on each side
-            cairo_show_text(s->cairo_draw, tic_text);
+            chart_show_text(s, tic_text);
             cairo_restore(s->cairo_draw);
 	}
     }
 }
 
+//! replay_png_in_bands - Replay the recording of a star chart onto a PNG file, rendering a horizontal band of pixels
+//! at a time, so that we never need to hold the full image in memory.
+//! \param s - Settings for the star chart we are drawing
+//! \param filename - The filename of the PNG file to write
+//! \param scale - The number of PNG pixels per unit of the recording surface
+
+static void replay_png_in_bands(chart_config *s, const char *filename, double scale) {
+    const int width = (int) (s->canvas_width * scale);
+    const int height = (int) (s->canvas_height * scale);
+    const int band_height = s->png_band_height;
+
+    FILE *output = open_output_stream(filename);
+    png_writer *writer = png_writer_open(output, width, height, s->png_compression_level, s->png_dpi);
+
+    // A single image surface is reused for every band
+    cairo_surface_t *band = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, band_height);
+    if (cairo_surface_status(band) != 0) {
+        snprintf(temp_err_string, 4096, "Could not create image surface. Error was: %s.",
+                 cairo_status_to_string(cairo_surface_status(band)));
+        stch_fatal(__FILE__, __LINE__, temp_err_string);
+        exit(1);
+    }
+
+    for (int y0 = 0; y0 < height; y0 += band_height) {
+        const int rows = (height - y0 < band_height) ? height - y0 : band_height;
+
+        // Clear the band, and then paint the part of the recording which falls within it
+        cairo_t *replay = cairo_create(band);
+        cairo_set_operator(replay, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(replay);
+        cairo_set_operator(replay, CAIRO_OPERATOR_OVER);
+        cairo_translate(replay, 0, -y0);
+        cairo_scale(replay, scale, scale);
+        if (s->svg_layer != NULL) {
+            svg_layer_replay(s->svg_layer, replay);
+        } else {
+            cairo_set_source_surface(replay, s->cairo_surface, 0, 0);
+            cairo_paint(replay);
+        }
+        cairo_destroy(replay);
+
+        // Pass the band to the PNG encoder
+        cairo_surface_flush(band);
+        png_writer_write_rows(writer, cairo_image_surface_get_data(band), cairo_image_surface_get_stride(band),
+                              rows);
+    }
+
+    cairo_surface_destroy(band);
+    png_writer_close(writer);
+    close_output_stream(output);
+}
+
 //! chart_finish - Finish drawing a star chart onto a cairo drawing surface. If needed, write it to disk now.
 //! \param p - A structure describing the status of the drawing surface
 //! \param s - Settings for the star chart we are drawing
@@ -824,7 +1108,7 @@ int chart_finish(cairo_page *p, chart_config *s) {
                    +s->width * s->aspect
                    + s->copyright_gap - 0.2
                    + s->copyright_gap_2) * s->cm);
-    cairo_show_text(s->cairo_draw, s->copyright);
+    chart_show_text(s, s->copyright);
 
     // Write lists of ticks to put on axes
     chart_ticks_draw(p, s, p->x_labels, "x");
@@ -837,27 +1121,45 @@ int chart_finish(cairo_page *p, chart_config *s) {
 
     // Close cairo drawing context
     cairo_destroy(s->cairo_draw);
-
-    if (s->output_format == SW_FORMAT_PNG) {
-        int cairo_status = cairo_surface_write_to_png(s->cairo_surface, s->output_filename);
-        if (cairo_status != 0) {
-            snprintf(temp_err_string, 4096, "Could not create PNG file. Error was: %s.",
-                     cairo_status_to_string(cairo_status));
-            stch_fatal(__FILE__, __LINE__, temp_err_string);
-            exit(1);
-        }
-
-        // Check that surface is OK
-        cairo_status = cairo_surface_status(s->cairo_surface);
-        if (cairo_status != 0) {
-            snprintf(temp_err_string, 4096, "Could not create output file. Error was: %s.",
-                     cairo_status_to_string(cairo_status));
-            stch_fatal(__FILE__, __LINE__, temp_err_string);
-            exit(1);
+    s->cairo_draw = NULL;
+    if (s->svg_layer != NULL) svg_layer_finish(s->svg_layer);
+
+    if (s->output_format == SW_FORMAT_RECORDING) {
+        // Replay the recording of the chart onto each of the output files in turn
+        for (int i = 0; i < s->output_count; i++) {
+            const int format = s->output_formats[i];
+            const double scale = output_format_dpi(s, format) / s->dpi;
+            if ((format == SW_FORMAT_PNG) && (s->png_band_height > 0)) {
+                replay_png_in_bands(s, s->output_filenames[i], scale);
+                continue;
+            }
+            if ((format == SW_FORMAT_SVG) && (s->svg_layer != NULL)) {
+                FILE *output = open_output_stream(s->output_filenames[i]);
+                svg_layer_write(s->svg_layer, output, s->canvas_width * scale, s->canvas_height * scale, scale);
+                close_output_stream(output);
+                continue;
+            }
+            cairo_surface_t *surface = create_output_surface(s->output_filenames[i], format,
+                                                             s->canvas_width * scale, s->canvas_height * scale);
+            cairo_t *replay = cairo_create(surface);
+            cairo_scale(replay, scale, scale);
+            if (s->svg_layer != NULL) {
+                svg_layer_replay(s->svg_layer, replay);
+            } else {
+                cairo_set_source_surface(replay, s->cairo_surface, 0, 0);
+                cairo_paint(replay);
+            }
+            cairo_destroy(replay);
+            close_output_surface(s, surface, s->output_filenames[i], format);
         }
+        cairo_surface_finish(s->cairo_surface);
+        cairo_surface_destroy(s->cairo_surface);
+        svg_layer_destroy(s->svg_layer);
+        s->svg_layer = NULL;
+    } else {
+        close_output_surface(s, s->cairo_surface, s->output_filenames[0], s->output_format);
     }
-
-    cairo_surface_finish(s->cairo_surface);
+    s->cairo_surface = NULL;
 
     return 0;
 }
@@ -45,7 +45,7 @@ typedef struct {
 } label_position;
 
 typedef struct {
-    label_position *possible_positions;
+    label_position possible_positions[MAX_LABEL_POSITIONS];
     int possible_position_count;
     chart_config *s;
     colour colour;
@@ -68,6 +68,11 @@ typedef struct {
 
     label_buffer_item *labels_buffer;
     int labels_buffer_counter;
+
+    // Storage for the strings of all the buffered text labels; emptied each time the buffer is rendered
+    char *label_string_store;
+    int label_string_store_used;
+
     exclusion_region *exclusion_regions;
     int exclusion_region_counter;
 } cairo_page;
@@ -80,6 +85,10 @@ void plot_background_image(chart_config *s);
 
 void draw_chart_edging(cairo_page *p, chart_config *s);
 
+void chart_show_text(chart_config *s, const char *text);
+
+int chart_clip_contains_box(const chart_config *s, double x_min, double x_max, double y_min, double y_max);
+
 void fetch_canvas_coordinates(double *x_out, double *y_out, double x_in, double y_in, chart_config *s);
 
 void fetch_graph_coordinates(double x_in, double y_in, double *x_out, double *y_out, chart_config *s);
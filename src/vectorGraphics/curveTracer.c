@@ -0,0 +1,309 @@
+// curveTracer.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// Trace curves across the sky, such as great circles and lines of constant RA and Dec, using as few projected
+// points as possible. Each curve is recursively bisected only where its projection deviates from a straight line by
+// more than a fraction of a pixel, and segments which lie entirely outside the field of view are not subdivided.
+// Where the curve is a circle on the sky, we work out analytically which arcs of it fall within the field of view,
+// and trace only those.
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+
+#include "mathsTools/projection.h"
+#include "mathsTools/sphericalTrig.h"
+#include "settings/chart_config.h"
+
+#include "vectorGraphics/curveTracer.h"
+#include "vectorGraphics/lineDraw.h"
+
+//! A single point along a curve we are tracing
+typedef struct {
+    //! The parameter value of this point
+    double t;
+
+    //! The projected position of this point (plot coordinates)
+    double x, y;
+
+    //! The angular distance of this point from the centre of the chart (radians)
+    double distance;
+} curve_sample;
+
+//! The state of a curve which is being traced
+typedef struct {
+    chart_config *s;
+    line_drawer *ld;
+    curve_function curve;
+    const void *context;
+    int grid_line;
+
+    //! Boolean flag indicating whether segments outside the field of view can be culled
+    int cull;
+
+    //! The angular radius of a cap, centred on the centre of the chart, which encloses the whole field of view
+    double field_radius;
+
+    //! The number of output pixels per unit of plot coordinates, horizontally and vertically
+    double x_scale, y_scale;
+
+    //! The number of points we have projected
+    int projection_count;
+} curve_tracer;
+
+//! curve_sample_point - Project the point with parameter <t> along the curve being traced
+//! \param self - The curve being traced
+//! \param t - The parameter value of the point
+//! \return - The projected point
+
+static curve_sample curve_sample_point(curve_tracer *self, double t) {
+    curve_sample out;
+    double lng, lat;
+    self->curve(self->context, t, &lng, &lat);
+    plane_project(&out.x, &out.y, self->s, lng, lat, self->grid_line);
+    self->projection_count++;
+
+    out.t = t;
+    out.distance = 0;
+    if (self->cull) {
+        // Positions which are not grid lines are converted into galactic coordinates by <plane_project>
+        if ((self->s->coords == SW_COORDS_GAL) && (!self->grid_line)) galactic_project(lng, lat, &lng, &lat);
+        out.distance = angDist_RADec(self->s->ra0, self->s->dec0, lng, lat);
+    }
+    return out;
+}
+
+//! curve_deviation - Calculate the distance of a midpoint from the chord joining the two ends of a segment
+//! \param self - The curve being traced
+//! \param a - The start of the segment
+//! \param m - The midpoint of the segment
+//! \param b - The end of the segment
+//! \return - The distance of <m> from the chord (output pixels)
+
+static double curve_deviation(const curve_tracer *self, const curve_sample *a, const curve_sample *m,
+                              const curve_sample *b) {
+    const double ax = a->x * self->x_scale, ay = a->y * self->y_scale;
+    const double bx = b->x * self->x_scale, by = b->y * self->y_scale;
+    const double mx = m->x * self->x_scale, my = m->y * self->y_scale;
+    const double dx = bx - ax, dy = by - ay;
+    const double length_squared = dx * dx + dy * dy;
+
+    // Project the midpoint onto the chord, clamping to the ends of the chord
+    double f = (length_squared > 0) ? ((mx - ax) * dx + (my - ay) * dy) / length_squared : 0;
+    if (f < 0) f = 0;
+    if (f > 1) f = 1;
+    return hypot(mx - (ax + f * dx), my - (ay + f * dy));
+}
+
+//! curve_point_in_field - Test whether a projected point lies within the plot area
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param p - The projected point
+//! \return - Boolean flag indicating whether the point is within the plot area
+
+static int curve_point_in_field(const chart_config *s, const curve_sample *p) {
+    return (p->x > s->x_min) && (p->x < s->x_max) && (p->y > s->y_min) && (p->y < s->y_max);
+}
+
+//! curve_chord_crosses_field - Test whether the straight line joining two projected points, both of which are outside
+//! the plot area, passes through it. The <line_drawer> only draws lines with at least one end in the plot area.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param a - The start of the segment
+//! \param b - The end of the segment
+//! \return - Boolean flag indicating whether the chord passes through the plot area
+
+static int curve_chord_crosses_field(const chart_config *s, const curve_sample *a, const curve_sample *b) {
+    if (!(gsl_finite(a->x) && gsl_finite(a->y) && gsl_finite(b->x) && gsl_finite(b->y))) return 0;
+    if (curve_point_in_field(s, a) || curve_point_in_field(s, b)) return 0;
+
+    // Clip the chord successively against each edge of the plot area (Liang-Barsky)
+    const double dx = b->x - a->x, dy = b->y - a->y;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {a->x - s->x_min, s->x_max - a->x, a->y - s->y_min, s->y_max - a->y};
+    double f_min = 0, f_max = 1;
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            if (q[i] < 0) return 0;
+            continue;
+        }
+        const double f = q[i] / p[i];
+        if (p[i] < 0) f_min = gsl_max(f_min, f);
+        else f_max = gsl_min(f_max, f);
+        if (f_min > f_max) return 0;
+    }
+    return 1;
+}
+
+//! curve_subdivide - Draw a segment of a curve, whose start has already been drawn, bisecting it as required
+//! \param self - The curve being traced
+//! \param a - The start of the segment
+//! \param b - The end of the segment
+//! \param depth - The number of times this segment has already been bisected
+
+static void curve_subdivide(curve_tracer *self, const curve_sample *a, const curve_sample *b, int depth) {
+    // Every point along the segment lies within half its length of one end, so if both ends are far enough
+    // outside the field of view, so is the whole segment
+    const double half_length = fabs(b->t - a->t) / 2;
+    const int outside_field = self->cull && (gsl_min(a->distance, b->distance) - half_length > self->field_radius);
+
+    // If the segment crosses the field of view without either end being inside it, we must bisect it until we
+    // find a point inside the field of view
+    const int crosses_field = (!outside_field) && curve_chord_crosses_field(self->s, a, b);
+
+    if ((!outside_field) && ((depth < CURVE_MAX_DEPTH) || (crosses_field && (depth < CURVE_MAX_CROSSING_DEPTH)))) {
+        const curve_sample m = curve_sample_point(self, (a->t + b->t) / 2);
+
+        // Bisect this segment if the curve strays from a straight line, or if its projection is discontinuous
+        const int finite = gsl_finite(a->x) && gsl_finite(b->x) && gsl_finite(m.x);
+        if ((!finite) || crosses_field || (curve_deviation(self, a, &m, b) > CURVE_TOLERANCE_PIXELS)) {
+            curve_subdivide(self, a, &m, depth + 1);
+            curve_subdivide(self, &m, b, depth + 1);
+            return;
+        }
+    }
+
+    ld_point(self->ld, b->x, b->y, NULL);
+}
+
+//! trace_sky_curve - Trace a curve across the sky, passing the minimum number of points required to draw it to
+//! within a fraction of a pixel to a <line_drawer>
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
+//! \param curve - Function returning the position of each point along the curve
+//! \param context - Pointer passed to <curve>, defining which curve to trace
+//! \param t_min - The parameter value at the start of the curve
+//! \param t_max - The parameter value at the end of the curve
+//! \param grid_line - Boolean indicating whether this is a grid-line, passed to <plane_project>
+//! \return - The number of points along the curve which were projected
+
+int trace_sky_curve(chart_config *s, line_drawer *ld, curve_function curve, const void *context,
+                    double t_min, double t_max, int grid_line) {
+    curve_tracer self;
+    self.s = s;
+    self.ld = ld;
+    self.curve = curve;
+    self.context = context;
+    self.grid_line = grid_line;
+    self.projection_count = 0;
+
+    // Flat projections cover the whole sky, and so we only cull segments when using zenithal projections
+    self.cull = (s->projection == SW_PROJECTION_GNOM) || (s->projection == SW_PROJECTION_SPH) ||
+                (s->projection == SW_PROJECTION_ALTAZ);
+    self.field_radius = self.cull ? field_of_view_radius(s) : M_PI;
+
+    // Conversion from plot coordinates into output pixels
+    const double pixels_per_cm = s->cm * s->raster_dpi / s->dpi;
+    self.x_scale = s->width * pixels_per_cm / (s->x_max - s->x_min);
+    self.y_scale = s->width * s->aspect * pixels_per_cm / (s->y_max - s->y_min);
+
+    // Divide the curve into equal initial segments, and then bisect each of these as required
+    curve_sample previous = curve_sample_point(&self, t_min);
+    ld_point(ld, previous.x, previous.y, NULL);
+
+    for (int i = 1; i <= CURVE_INITIAL_SEGMENTS; i++) {
+        const double t = t_min + (t_max - t_min) * ((double) i) / CURVE_INITIAL_SEGMENTS;
+        const curve_sample next = curve_sample_point(&self, t);
+        curve_subdivide(&self, &previous, &next, 0);
+        previous = next;
+    }
+
+    return self.projection_count;
+}
+
+//! sky_circle_point - Return the position of a point along a <sky_circle>
+//! \param context - Pointer to the <sky_circle> to trace
+//! \param t - The parameter of the point along the circle (radians)
+//! \param [out] lng - The longitude of the point (radians)
+//! \param [out] lat - The latitude of the point (radians)
+
+static void sky_circle_point(const void *context, double t, double *lng, double *lat) {
+    const sky_circle *circle = (const sky_circle *) context;
+    const double c = cos(t), s = sin(t);
+    double a[3];
+    for (int i = 0; i < 3; i++) a[i] = circle->centre[i] + c * circle->u[i] + s * circle->v[i];
+
+    *lat = asin(gsl_max(-1, gsl_min(1, a[2])));
+    *lng = atan2(a[1], a[0]);
+}
+
+//! trace_sky_circle - Trace the parts of a circle on the sky which fall within the field of view. The field of view
+//! is enclosed within a cap on the celestial sphere, and the parameter range over which the circle lies within that
+//! cap is found by intersecting the two in three dimensions.
+//! \param s - A <chart_config> structure defining the properties of the star chart to be drawn.
+//! \param ld - A <line_drawer> structure used to draw lines on a cairo surface.
+//! \param circle - The circle to trace
+//! \param t_min - The parameter value at the start of the part of the circle to trace (radians)
+//! \param t_max - The parameter value at the end of the part of the circle to trace (radians)
+//! \param grid_line - Boolean indicating whether this is a grid-line, passed to <plane_project>
+//! \return - The number of points along the circle which were projected
+
+int trace_sky_circle(chart_config *s, line_drawer *ld, const sky_circle *circle, double t_min, double t_max,
+                     int grid_line) {
+    // Circles which are not grid lines are converted from RA/Dec into galactic coordinates by <plane_project>,
+    // whereas the centre of the chart is in galactic coordinates, so we don't attempt to clip them
+    const int zenithal = (s->projection == SW_PROJECTION_GNOM) || (s->projection == SW_PROJECTION_SPH) ||
+                         (s->projection == SW_PROJECTION_ALTAZ);
+    const int same_frame = grid_line || (s->coords != SW_COORDS_GAL);
+    const double field_radius = zenithal ? field_of_view_radius(s) * (1 + CURVE_VISIBLE_ARC_MARGIN) : M_PI;
+
+    if ((!same_frame) || (field_radius >= M_PI)) {
+        return trace_sky_curve(s, ld, sky_circle_point, circle, t_min, t_max, grid_line);
+    }
+
+    // The unit vector pointing at the centre of the chart
+    const double chart_centre[3] = {cos(s->dec0) * cos(s->ra0), cos(s->dec0) * sin(s->ra0), sin(s->dec0)};
+
+    // The cosine of the angular distance of the point with parameter t from the centre of the chart is
+    // a + b * cos(t - t0). This must exceed the cosine of the radius of the field of view.
+    double a = 0, b_cos = 0, b_sin = 0;
+    for (int i = 0; i < 3; i++) {
+        a += circle->centre[i] * chart_centre[i];
+        b_cos += circle->u[i] * chart_centre[i];
+        b_sin += circle->v[i] * chart_centre[i];
+    }
+    const double b = hypot(b_cos, b_sin);
+    const double threshold = cos(field_radius);
+
+    // Circle lies entirely outside the field of view
+    if (a + b < threshold) return 0;
+
+    // Circle lies entirely inside the field of view
+    if ((a - b >= threshold) || (b <= 0)) {
+        return trace_sky_curve(s, ld, sky_circle_point, circle, t_min, t_max, grid_line);
+    }
+
+    // The visible arc spans t0 - half_width to t0 + half_width. Intersect this with the range [t_min, t_max],
+    // allowing for the arc to appear at any multiple of 2pi.
+    const double t0 = atan2(b_sin, b_cos);
+    const double half_width = acos((threshold - a) / b);
+    int projection_count = 0;
+
+    const int k_min = (int) floor((t_min - t0 - half_width) / (2 * M_PI));
+    const int k_max = (int) ceil((t_max - t0 + half_width) / (2 * M_PI));
+    for (int k = k_min; k <= k_max; k++) {
+        const double arc_start = gsl_max(t_min, t0 + 2 * M_PI * k - half_width);
+        const double arc_end = gsl_min(t_max, t0 + 2 * M_PI * k + half_width);
+        if (arc_end <= arc_start) continue;
+        projection_count += trace_sky_curve(s, ld, sky_circle_point, circle, arc_start, arc_end, grid_line);
+    }
+
+    return projection_count;
+}
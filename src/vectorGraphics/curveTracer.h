@@ -0,0 +1,62 @@
+// curveTracer.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef CURVE_TRACER_H
+#define CURVE_TRACER_H 1
+
+#include "settings/chart_config.h"
+#include "vectorGraphics/lineDraw.h"
+
+//! The number of equal segments a curve is divided into before adaptive subdivision begins
+#define CURVE_INITIAL_SEGMENTS 16
+
+//! The maximum number of times each initial segment may be bisected
+#define CURVE_MAX_DEPTH 7
+
+//! The maximum number of times each initial segment may be bisected to find a point within the field of view, when
+//! the straight line joining its two ends crosses the field of view
+#define CURVE_MAX_CROSSING_DEPTH 24
+
+//! The maximum distance, in output pixels, by which a curve may deviate from the straight lines used to draw it
+#define CURVE_TOLERANCE_PIXELS 0.25
+
+//! The fractional amount by which we enlarge the field of view when working out which arcs of a circle are visible,
+//! so that each visible arc starts and ends outside the plot area
+#define CURVE_VISIBLE_ARC_MARGIN 0.01
+
+//! A circle on the celestial sphere (either a great circle or a small circle), described in Cartesian coordinates.
+//! The point with parameter t lies at <centre> + cos(t) * <u> + sin(t) * <v>, where <u> and <v> are orthogonal
+//! vectors of equal length, perpendicular to <centre>.
+typedef struct {
+    double centre[3], u[3], v[3];
+} sky_circle;
+
+//! A function returning the position on the sky of the point with parameter <t> along a curve. The parameter must be
+//! an angle (radians) which advances at least as fast as the angular distance travelled along the curve.
+typedef void (*curve_function)(const void *context, double t, double *lng, double *lat);
+
+int trace_sky_curve(chart_config *s, line_drawer *ld, curve_function curve, const void *context,
+                    double t_min, double t_max, int grid_line);
+
+int trace_sky_circle(chart_config *s, line_drawer *ld, const sky_circle *circle, double t_min, double t_max,
+                     int grid_line);
+
+#endif
@@ -48,6 +48,74 @@ static void list_add_tick(list *l, double x, const char *label) {
     listAppendPtr(l, buff, FNAME_LENGTH, 0, DATATYPE_VOID);
 }
 
+//! ld_flush_vertices - Pass any vertices held back by the line simplification stage to cairo
+//! \param self - The <line_drawer> structure used to hold data about this line drawing module instance.
+
+static void ld_flush_vertices(line_drawer *self) {
+    if (self->pending_count > 0) {
+        const int last = self->pending_count - 1;
+        cairo_line_to(self->s->cairo_draw, self->pending_x[last], self->pending_y[last]);
+        self->anchor_x = self->pending_x[last];
+        self->anchor_y = self->pending_y[last];
+    }
+    self->pending_count = 0;
+}
+
+//! ld_segment_distance - Return the distance of the point (x, y) from the line segment (x0, y0) - (x1, y1)
+
+static double ld_segment_distance(double x, double y, double x0, double y0, double x1, double y1) {
+    const double dx = x1 - x0, dy = y1 - y0;
+    const double length_squared = dx * dx + dy * dy;
+    double f = (length_squared > 0) ? ((x - x0) * dx + (y - y0) * dy) / length_squared : 0;
+    f = gsl_max(0, gsl_min(1, f));
+    return hypot(x - (x0 + f * dx), y - (y0 + f * dy));
+}
+
+//! ld_vertex - Add a vertex to the path we are drawing, via a streaming simplification stage which merges runs of
+//! vertices that lie within <simplify_tolerance> of a straight line into a single segment. The first and last vertex
+//! of each stroke are always kept.
+//! \param self - The <line_drawer> structure used to hold data about this line drawing module instance.
+//! \param x - The x coordinate (cairo coordinates) of the vertex
+//! \param y - The y coordinate (cairo coordinates) of the vertex
+
+static void ld_vertex(line_drawer *self, double x, double y) {
+    int i;
+
+    if (!self->haddata) {
+        cairo_new_path(self->s->cairo_draw);
+        cairo_move_to(self->s->cairo_draw, x, y);
+        self->haddata = 1;
+    } else if (!self->anchor_valid) {
+        // Start a new sub-path
+        cairo_move_to(self->s->cairo_draw, x, y);
+    } else if (self->simplify_tolerance <= 0) {
+        cairo_line_to(self->s->cairo_draw, x, y);
+    } else {
+        // Check whether all the vertices held back since the anchor lie close to the segment from anchor to (x, y)
+        int mergeable = (self->pending_count < LD_SIMPLIFY_BUFFER);
+        for (i = 0; mergeable && (i < self->pending_count); i++) {
+            const double d = ld_segment_distance(self->pending_x[i], self->pending_y[i],
+                                                 self->anchor_x, self->anchor_y, x, y);
+            if (d > self->simplify_tolerance) mergeable = 0;
+        }
+
+        // If not, the last vertex held back must be drawn, and becomes the new anchor
+        if (!mergeable) ld_flush_vertices(self);
+
+        self->unstroked = 1;
+        self->pending_x[self->pending_count] = x;
+        self->pending_y[self->pending_count] = y;
+        self->pending_count++;
+        return;
+    }
+
+    self->unstroked = 1;
+    self->anchor_valid = 1;
+    self->anchor_x = x;
+    self->anchor_y = y;
+    self->pending_count = 0;
+}
+
 //Solve second degree equation
 void solve2deg(double *sol1, double *sol2, double a, double b, double c){
 	double delta= b*b-4*a*c;
@@ -210,6 +278,11 @@ void ld_init(line_drawer *self, chart_config *s, list *xlabels, list *x2labels,
     self->wlin = s->wlin;
     self->xold = GSL_NAN;
     self->yold = GSL_NAN;
+    self->simplify_tolerance = s->line_simplification * s->dpi / s->raster_dpi;
+    self->anchor_valid = 0;
+    self->pending_count = 0;
+    self->batch_strokes = 0;
+    self->unstroked = 0;
     ld_pen_up(self, GSL_NAN, GSL_NAN, NULL, 1);
     cairo_set_line_width(s->cairo_draw, 1.0 * s->line_width_base);
 }
@@ -239,8 +312,10 @@ void ld_label(line_drawer *self, char *l, int label_on_x, int label_on_y, int la
 void ld_pen_up(line_drawer *self, double x, double y, const char *name, int new_line) {
     if ((gsl_finite(x)) && (!self->penup)) ld_point(self, x, y, name);
     if (!self->penup) {
-        cairo_stroke(self->s->cairo_draw);
+        ld_flush_vertices(self);
+        if (!self->batch_strokes) ld_stroke(self);
     }
+    self->anchor_valid = 0;
     self->penup = 1;
     if (new_line) { self->xold = self->yold = GSL_NAN; }
 }
@@ -250,6 +325,27 @@ void ld_pen_up(line_drawer *self, double x, double y, const char *name, int new_
 
 void ld_close(line_drawer *self) {
     ld_pen_up(self, GSL_NAN, GSL_NAN, "", 1);
+    ld_stroke(self);
+}
+
+//! ld_batch_strokes - Set whether lines are stroked individually when the pen is lifted, or accumulated as separate
+//! sub-paths and stroked together. Lines drawn in batch mode must all share the same style, so <ld_stroke> must be
+//! called before changing the colour or width of the line.
+//! \param self - The <line_drawer> structure used to hold data about this line drawing module instance.
+//! \param batch - Boolean flag indicating whether to batch strokes. Turning batching off strokes any pending lines.
+
+void ld_batch_strokes(line_drawer *self, int batch) {
+    if (!batch) ld_stroke(self);
+    self->batch_strokes = batch;
+}
+
+//! ld_stroke - Stroke any lines which have been drawn but not yet stroked
+//! \param self - The <line_drawer> structure used to hold data about this line drawing module instance.
+
+void ld_stroke(line_drawer *self) {
+    ld_flush_vertices(self);
+    if (self->unstroked) cairo_stroke(self->s->cairo_draw);
+    self->unstroked = 0;
 }
 
 //! ld_point - Add a point to a line we're drawing
@@ -321,18 +417,10 @@ void ld_point_plot(line_drawer *self, double x, double y, const char *name) {
                              self->label_on_y ? self->y2labels : NULL);
 
             fetch_canvas_coordinates(&x_canvas, &y_canvas, xo, yo, self->s);
-            if (!self->haddata) {
-                cairo_new_path(self->s->cairo_draw);
-                cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-            } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-            self->haddata = 1;
+            ld_vertex(self, x_canvas, y_canvas);
         }
         fetch_canvas_coordinates(&x_canvas, &y_canvas, x, y, self->s);
-        if (!self->haddata) {
-            cairo_new_path(self->s->cairo_draw);
-            cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-        } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-        self->haddata = 1;
+        ld_vertex(self, x_canvas, y_canvas);
         self->penup = 0;
     } else {
         if ((gsl_finite(self->xold)) && (!self->penup)) {
@@ -345,11 +433,7 @@ void ld_point_plot(line_drawer *self, double x, double y, const char *name) {
                              self->label_on_y ? self->y2labels : NULL);
 
             fetch_canvas_coordinates(&x_canvas, &y_canvas, xo, yo, self->s);
-            if (!self->haddata) {
-                cairo_new_path(self->s->cairo_draw);
-                cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-            } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-            self->haddata = 1;
+            ld_vertex(self, x_canvas, y_canvas);
         }
         ld_pen_up(self, GSL_NAN, GSL_NAN, NULL, 0);
     }
@@ -369,18 +453,10 @@ void ld_point_plot_round(line_drawer *self, double x, double y, const char *name
                              self->label_on_r ? self->rlabels : NULL);
 
             fetch_canvas_coordinates(&x_canvas, &y_canvas, xo, yo, self->s);
-            if (!self->haddata) {
-                cairo_new_path(self->s->cairo_draw);
-                cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-            } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-            self->haddata = 1;
+            ld_vertex(self, x_canvas, y_canvas);
         }
         fetch_canvas_coordinates(&x_canvas, &y_canvas, x, y, self->s);
-        if (!self->haddata) {
-            cairo_new_path(self->s->cairo_draw);
-            cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-        } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-        self->haddata = 1;
+        ld_vertex(self, x_canvas, y_canvas);
         self->penup = 0;
     } else {
         if ((gsl_finite(self->xold)) && (!self->penup)) {
@@ -390,11 +466,7 @@ void ld_point_plot_round(line_drawer *self, double x, double y, const char *name
                              self->label_on_r ? self->rlabels : NULL);
 
             fetch_canvas_coordinates(&x_canvas, &y_canvas, xo, yo, self->s);
-            if (!self->haddata) {
-                cairo_new_path(self->s->cairo_draw);
-                cairo_move_to(self->s->cairo_draw, x_canvas, y_canvas);
-            } else cairo_line_to(self->s->cairo_draw, x_canvas, y_canvas);
-            self->haddata = 1;
+            ld_vertex(self, x_canvas, y_canvas);
         }
         ld_pen_up(self, GSL_NAN, GSL_NAN, NULL, 0);
     }
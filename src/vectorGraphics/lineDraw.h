@@ -29,6 +29,10 @@
 
 #include "settings/chart_config.h"
 
+//! The maximum number of consecutive vertices which may be merged into a single straight segment by the line
+//! simplification stage
+#define LD_SIMPLIFY_BUFFER 64
+
 typedef struct ld_handle {
     char *label;
     int label_on_x, label_on_y, label_on_r;
@@ -37,6 +41,25 @@ typedef struct ld_handle {
     double xmin, xmax, ymin, ymax, wlin;
     chart_config *s;
     double xold, yold;
+
+    //! Boolean flag indicating whether lifting the pen leaves lines in the current path, to be stroked together by
+    //! <ld_stroke>, rather than stroking each one individually
+    int batch_strokes;
+
+    //! Boolean flag indicating whether the current path contains lines which have not yet been stroked
+    int unstroked;
+
+    //! The maximum distance (cairo coordinates) by which the simplified line may deviate from the sampled points
+    double simplify_tolerance;
+
+    //! The last vertex (cairo coordinates) we passed to cairo, from which the current straight segment starts
+    int anchor_valid;
+    double anchor_x, anchor_y;
+
+    //! Vertices (cairo coordinates) we have received since <anchor> but not yet passed to cairo. All but the last lie
+    //! within <simplify_tolerance> of the straight line from <anchor> to the last.
+    int pending_count;
+    double pending_x[LD_SIMPLIFY_BUFFER], pending_y[LD_SIMPLIFY_BUFFER];
 } line_drawer;
 
 void truncate_at_axis(double *xout, double *yout, double x0, double y0, double x1, double y1, double xmin, double xmax,
@@ -54,6 +77,10 @@ void ld_pen_up(line_drawer *self, double x, double y, const char *name, int new_
 
 void ld_close(line_drawer *self);
 
+void ld_batch_strokes(line_drawer *self, int batch);
+
+void ld_stroke(line_drawer *self);
+
 void ld_point(line_drawer *self, double x, double y, const char *name);
 
 void ld_point_plot(line_drawer *self, double x, double y, const char *name);
@@ -0,0 +1,456 @@
+// pngWriter.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// A PNG encoder for cairo ARGB32 image data, which spreads the work across multiple threads. Each band of rows is
+// unpremultiplied and filtered one row per thread, and then split into chunks which are deflated concurrently. Each
+// chunk is primed with the 32 kB of data which precede it, and ends with a sync flush, so that the compressed chunks
+// can simply be concatenated to form a single valid zlib stream.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <zlib.h>
+
+#include "coreUtils/errorReport.h"
+
+#include "vectorGraphics/pngWriter.h"
+
+//! The number of rows we pass to <png_writer_write_rows> at a time when writing a complete image
+#define PNG_BAND_ROWS 256
+
+//! The output of compressing a single chunk of filtered image data
+typedef struct {
+    unsigned char *data;
+    unsigned long length;
+    unsigned long adler;
+} png_compressed_chunk;
+
+//! png_fwrite - Write bytes to the output PNG file, and throw a fatal error if this fails
+//! \param data - The bytes to write
+//! \param length - The number of bytes to write
+//! \param output - The stream to write to
+
+static void png_fwrite(const void *data, size_t length, FILE *output) {
+    if (fwrite(data, 1, length, output) != length) {
+        stch_fatal(__FILE__, __LINE__, "Could not write PNG file.");
+        exit(1);
+    }
+}
+
+//! png_write_uint32 - Write a 32-bit integer to the output PNG file in network byte order
+//! \param value - The integer to write
+//! \param output - The stream to write to
+
+static void png_write_uint32(uint32_t value, FILE *output) {
+    const unsigned char bytes[4] = {
+            (unsigned char) (value >> 24), (unsigned char) (value >> 16),
+            (unsigned char) (value >> 8), (unsigned char) value
+    };
+    png_fwrite(bytes, 4, output);
+}
+
+//! png_write_chunk - Write a chunk to a PNG file, whose data is made up of a number of separate pieces
+//! \param output - The stream to write to
+//! \param type - The four-character chunk type, e.g. "IDAT"
+//! \param pieces - The pieces of data which make up the chunk
+//! \param lengths - The length of each of the pieces of data
+//! \param piece_count - The number of pieces of data
+
+static void png_write_chunk(FILE *output, const char *type, const unsigned char **pieces,
+                            const unsigned long *lengths, int piece_count) {
+    unsigned long total_length = 0;
+    for (int i = 0; i < piece_count; i++) total_length += lengths[i];
+
+    png_write_uint32((uint32_t) total_length, output);
+    png_fwrite(type, 4, output);
+
+    // The CRC covers the chunk type and the chunk data
+    unsigned long crc = crc32(0L, (const Bytef *) type, 4);
+    for (int i = 0; i < piece_count; i++) {
+        png_fwrite(pieces[i], lengths[i], output);
+        crc = crc32(crc, pieces[i], (uInt) lengths[i]);
+    }
+    png_write_uint32((uint32_t) crc, output);
+}
+
+//! png_paeth - The Paeth predictor used by PNG filter type 4
+//! \param a - The byte to the left
+//! \param b - The byte above
+//! \param c - The byte above and to the left
+//! \return - The predicted value of the byte
+
+static inline int png_paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = abs(p - a);
+    const int pb = abs(p - b);
+    const int pc = abs(p - c);
+    if ((pa <= pb) && (pa <= pc)) return a;
+    if (pb <= pc) return b;
+    return c;
+}
+
+//! png_filter_row - Apply whichever of the five PNG row filters produces the smallest sum of absolute residuals
+//! \param out - Buffer of length <1 + row_length> into which to write the filter type and filtered row
+//! \param row - The unfiltered bytes of this row
+//! \param prior - The unfiltered bytes of the previous row
+//! \param row_length - The number of bytes in each row
+//! \param scratch - Buffer of length <row_length> to use as working space
+
+static void png_filter_row(unsigned char *out, const unsigned char *row, const unsigned char *prior,
+                           int row_length, unsigned char *scratch) {
+    const int bpp = 4;
+    unsigned long best_sum = ~0UL;
+
+    for (int filter = 0; filter < 5; filter++) {
+        unsigned char *candidate = (filter == 0) ? out + 1 : scratch;
+        unsigned long sum = 0;
+
+        for (int i = 0; i < row_length; i++) {
+            const int a = (i >= bpp) ? row[i - bpp] : 0;
+            const int b = prior[i];
+            const int c = (i >= bpp) ? prior[i - bpp] : 0;
+            int predicted;
+            switch (filter) {
+                case 1:
+                    predicted = a;
+                    break;
+                case 2:
+                    predicted = b;
+                    break;
+                case 3:
+                    predicted = (a + b) / 2;
+                    break;
+                case 4:
+                    predicted = png_paeth(a, b, c);
+                    break;
+                default:
+                    predicted = 0;
+                    break;
+            }
+            const unsigned char residual = (unsigned char) (row[i] - predicted);
+            candidate[i] = residual;
+            sum += (residual < 128) ? residual : (256 - residual);
+        }
+
+        if (sum < best_sum) {
+            best_sum = sum;
+            out[0] = (unsigned char) filter;
+            if (filter != 0) memcpy(out + 1, scratch, row_length);
+        }
+    }
+}
+
+//! png_compress_chunk - Compress a chunk of filtered image data as a raw deflate stream ending in a sync flush
+//! \param out - The structure to populate with the compressed data
+//! \param data - The data to compress
+//! \param length - The number of bytes to compress
+//! \param dictionary - The data immediately preceding this chunk, used to prime the compressor
+//! \param dictionary_length - The number of bytes in <dictionary>
+//! \param compression_level - The zlib compression level, 0-9
+
+static void png_compress_chunk(png_compressed_chunk *out, const unsigned char *data, unsigned long length,
+                               const unsigned char *dictionary, int dictionary_length, int compression_level) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        stch_fatal(__FILE__, __LINE__, "Could not initialise zlib.");
+        exit(1);
+    }
+    if (dictionary_length > 0) deflateSetDictionary(&stream, dictionary, (uInt) dictionary_length);
+
+    // Allow space for the worst-case expansion of the data, plus the empty stored block emitted by the sync flush
+    const unsigned long buffer_size = deflateBound(&stream, length) + 16;
+    out->data = (unsigned char *) malloc(buffer_size);
+    if (out->data == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    stream.next_in = (Bytef *) data;
+    stream.avail_in = (uInt) length;
+    stream.next_out = out->data;
+    stream.avail_out = (uInt) buffer_size;
+
+    const int status = deflate(&stream, Z_SYNC_FLUSH);
+    if ((status != Z_OK) || (stream.avail_in != 0) || (stream.avail_out == 0)) {
+        stch_fatal(__FILE__, __LINE__, "zlib compression failed.");
+        exit(1);
+    }
+
+    out->length = buffer_size - stream.avail_out;
+    out->adler = adler32(adler32(0L, Z_NULL, 0), data, (uInt) length);
+    deflateEnd(&stream);
+}
+
+//! png_writer_open - Start writing a PNG file, and write its header
+//! \param output - The stream to write the PNG file to
+//! \param width - The width of the image, in pixels
+//! \param height - The height of the image, in pixels
+//! \param compression_level - The zlib compression level, 0-9
+//! \param dpi - The resolution of the image, in pixels per inch, which is recorded in the file's pHYs chunk
+//! \return - A handle to pass to <png_writer_write_rows> and <png_writer_close>
+
+png_writer *png_writer_open(FILE *output, int width, int height, int compression_level, double dpi) {
+    png_writer *self = (png_writer *) malloc(sizeof(png_writer));
+    if (self == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    if (compression_level < 0) compression_level = 0;
+    if (compression_level > 9) compression_level = 9;
+
+    self->output = output;
+    self->width = width;
+    self->height = height;
+    self->compression_level = compression_level;
+    self->rows_written = 0;
+    self->row_bytes = 1 + 4 * width;
+    self->dictionary_length = 0;
+    self->adler = adler32(0L, Z_NULL, 0);
+
+    // The row above the first row is treated as being all zeros
+    self->previous_row = (unsigned char *) calloc((size_t) 4 * width, 1);
+    if (self->previous_row == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    // PNG signature
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    png_fwrite(signature, 8, output);
+
+    // IHDR chunk: 8-bit RGBA, deflate compression, adaptive filtering, no interlacing
+    const unsigned char ihdr[13] = {
+            (unsigned char) (width >> 24), (unsigned char) (width >> 16),
+            (unsigned char) (width >> 8), (unsigned char) width,
+            (unsigned char) (height >> 24), (unsigned char) (height >> 16),
+            (unsigned char) (height >> 8), (unsigned char) height,
+            8, 6, 0, 0, 0
+    };
+    const unsigned char *ihdr_pieces[1] = {ihdr};
+    const unsigned long ihdr_lengths[1] = {13};
+    png_write_chunk(output, "IHDR", ihdr_pieces, ihdr_lengths, 1);
+
+    // pHYs chunk: the physical resolution of the image, in pixels per metre
+    const uint32_t pixels_per_metre = (uint32_t) (dpi / 0.0254 + 0.5);
+    const unsigned char phys[9] = {
+            (unsigned char) (pixels_per_metre >> 24), (unsigned char) (pixels_per_metre >> 16),
+            (unsigned char) (pixels_per_metre >> 8), (unsigned char) pixels_per_metre,
+            (unsigned char) (pixels_per_metre >> 24), (unsigned char) (pixels_per_metre >> 16),
+            (unsigned char) (pixels_per_metre >> 8), (unsigned char) pixels_per_metre,
+            1
+    };
+    const unsigned char *phys_pieces[1] = {phys};
+    const unsigned long phys_lengths[1] = {9};
+    png_write_chunk(output, "pHYs", phys_pieces, phys_lengths, 1);
+
+    return self;
+}
+
+//! png_writer_write_rows - Compress and write the next band of rows of a PNG image
+//! \param self - The PNG file we are writing
+//! \param data - Cairo ARGB32 pixel data for the rows, with premultiplied alpha
+//! \param stride - The number of bytes between the starts of successive rows in <data>
+//! \param row_count - The number of rows to write
+
+void png_writer_write_rows(png_writer *self, const unsigned char *data, int stride, int row_count) {
+    int j;
+    const int width = self->width;
+    const int row_length = 4 * width;
+    const int row_bytes = self->row_bytes;
+
+    if (row_count <= 0) return;
+    if (self->rows_written + row_count > self->height) {
+        stch_fatal(__FILE__, __LINE__, "Too many rows written to PNG file.");
+        exit(1);
+    }
+
+    // Buffers for the unpremultiplied RGBA pixels, and the filtered rows
+    unsigned char *pixels = (unsigned char *) malloc((size_t) row_length * row_count);
+    unsigned char *filtered = (unsigned char *) malloc((size_t) row_bytes * row_count);
+    if ((pixels == NULL) || (filtered == NULL)) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    // Convert cairo's native-endian premultiplied ARGB into unpremultiplied RGBA bytes
+#pragma omp parallel for shared(pixels) private(j)
+    for (j = 0; j < row_count; j++) {
+        const uint32_t *in = (const uint32_t *) (data + (size_t) j * stride);
+        unsigned char *out = pixels + (size_t) j * row_length;
+        for (int i = 0; i < width; i++) {
+            const uint32_t pixel = in[i];
+            const unsigned int alpha = pixel >> 24;
+            if (alpha == 0) {
+                out[4 * i] = out[4 * i + 1] = out[4 * i + 2] = out[4 * i + 3] = 0;
+            } else {
+                out[4 * i] = (unsigned char) ((((pixel >> 16) & 0xff) * 255 + alpha / 2) / alpha);
+                out[4 * i + 1] = (unsigned char) ((((pixel >> 8) & 0xff) * 255 + alpha / 2) / alpha);
+                out[4 * i + 2] = (unsigned char) (((pixel & 0xff) * 255 + alpha / 2) / alpha);
+                out[4 * i + 3] = (unsigned char) alpha;
+            }
+        }
+    }
+
+    // Apply PNG row filters
+#pragma omp parallel shared(pixels, filtered) private(j)
+    {
+        unsigned char *scratch = (unsigned char *) malloc((size_t) row_length);
+#pragma omp for
+        for (j = 0; j < row_count; j++) {
+            const unsigned char *prior = (j == 0) ? self->previous_row : pixels + (size_t) (j - 1) * row_length;
+            png_filter_row(filtered + (size_t) j * row_bytes, pixels + (size_t) j * row_length, prior,
+                           row_length, scratch);
+        }
+        free(scratch);
+    }
+
+    // Keep the last row, which is needed to filter the first row of the next band
+    memcpy(self->previous_row, pixels + (size_t) (row_count - 1) * row_length, row_length);
+    free(pixels);
+
+    // Compress the filtered data in independent chunks
+    const unsigned long filtered_length = (unsigned long) row_bytes * row_count;
+    const int chunk_count = (int) ((filtered_length + PNG_CHUNK_SIZE - 1) / PNG_CHUNK_SIZE);
+    png_compressed_chunk *chunks = (png_compressed_chunk *) malloc(chunk_count * sizeof(png_compressed_chunk));
+    if (chunks == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+#pragma omp parallel for shared(chunks, filtered) private(j) schedule(dynamic)
+    for (j = 0; j < chunk_count; j++) {
+        const unsigned long start = (unsigned long) j * PNG_CHUNK_SIZE;
+        const unsigned long end = (start + PNG_CHUNK_SIZE < filtered_length) ? start + PNG_CHUNK_SIZE : filtered_length;
+
+        // Prime each chunk with the data which precedes it. The first chunk of each band is primed with the tail
+        // of the previous band. PNG_CHUNK_SIZE >= PNG_DICTIONARY_SIZE, so later chunks are always preceded by a full
+        // window of data from this band.
+        if (j == 0) {
+            png_compress_chunk(&chunks[j], filtered, end, self->dictionary, self->dictionary_length,
+                               self->compression_level);
+        } else {
+            png_compress_chunk(&chunks[j], filtered + start, end - start,
+                               filtered + start - PNG_DICTIONARY_SIZE, PNG_DICTIONARY_SIZE,
+                               self->compression_level);
+        }
+    }
+
+    // Write all of the compressed chunks into a single IDAT chunk. The first band starts with the zlib header.
+    const unsigned char **pieces = (const unsigned char **) malloc((chunk_count + 1) * sizeof(unsigned char *));
+    unsigned long *lengths = (unsigned long *) malloc((chunk_count + 1) * sizeof(unsigned long));
+    int piece_count = 0;
+
+    unsigned char zlib_header[2];
+    if (self->rows_written == 0) {
+        // 32 kB window, deflate; FLEVEL records the compression level; FCHECK makes the header a multiple of 31
+        const int flevel = (self->compression_level < 2) ? 0 :
+                           ((self->compression_level < 6) ? 1 : ((self->compression_level == 6) ? 2 : 3));
+        zlib_header[0] = 0x78;
+        zlib_header[1] = (unsigned char) (flevel << 6);
+        zlib_header[1] += 31 - ((zlib_header[0] * 256 + zlib_header[1]) % 31);
+        pieces[piece_count] = zlib_header;
+        lengths[piece_count] = 2;
+        piece_count++;
+    }
+
+    for (j = 0; j < chunk_count; j++) {
+        const unsigned long start = (unsigned long) j * PNG_CHUNK_SIZE;
+        const unsigned long end = (start + PNG_CHUNK_SIZE < filtered_length) ? start + PNG_CHUNK_SIZE : filtered_length;
+        pieces[piece_count] = chunks[j].data;
+        lengths[piece_count] = chunks[j].length;
+        piece_count++;
+        self->adler = adler32_combine(self->adler, chunks[j].adler, (z_off_t) (end - start));
+    }
+
+    png_write_chunk(self->output, "IDAT", pieces, lengths, piece_count);
+
+    // Keep the tail of this band, which is used to prime the compression of the next band
+    if (filtered_length >= PNG_DICTIONARY_SIZE) {
+        memcpy(self->dictionary, filtered + filtered_length - PNG_DICTIONARY_SIZE, PNG_DICTIONARY_SIZE);
+        self->dictionary_length = PNG_DICTIONARY_SIZE;
+    } else {
+        const int keep = (self->dictionary_length + filtered_length > PNG_DICTIONARY_SIZE) ?
+                         PNG_DICTIONARY_SIZE - (int) filtered_length : self->dictionary_length;
+        memmove(self->dictionary, self->dictionary + self->dictionary_length - keep, keep);
+        memcpy(self->dictionary + keep, filtered, filtered_length);
+        self->dictionary_length = keep + (int) filtered_length;
+    }
+
+    // Clean up
+    for (j = 0; j < chunk_count; j++) free(chunks[j].data);
+    free(chunks);
+    free(pieces);
+    free(lengths);
+    free(filtered);
+
+    self->rows_written += row_count;
+}
+
+//! png_writer_close - Terminate the compressed image data, write the end of the PNG file, and free the writer
+//! \param self - The PNG file we are writing
+
+void png_writer_close(png_writer *self) {
+    if (self->rows_written != self->height) {
+        stch_fatal(__FILE__, __LINE__, "PNG file closed before all rows were written.");
+        exit(1);
+    }
+
+    // An empty final fixed-Huffman deflate block, followed by the Adler-32 checksum of the uncompressed data
+    const unsigned char zlib_trailer[6] = {
+            0x03, 0x00,
+            (unsigned char) (self->adler >> 24), (unsigned char) (self->adler >> 16),
+            (unsigned char) (self->adler >> 8), (unsigned char) self->adler
+    };
+    const unsigned char *idat_pieces[1] = {zlib_trailer};
+    const unsigned long idat_lengths[1] = {6};
+    png_write_chunk(self->output, "IDAT", idat_pieces, idat_lengths, 1);
+    png_write_chunk(self->output, "IEND", NULL, NULL, 0);
+
+    free(self->previous_row);
+    free(self);
+}
+
+//! png_write_argb32 - Write a complete cairo ARGB32 image to a PNG file
+//! \param output - The stream to write the PNG file to
+//! \param data - Cairo ARGB32 pixel data, with premultiplied alpha
+//! \param width - The width of the image, in pixels
+//! \param height - The height of the image, in pixels
+//! \param stride - The number of bytes between the starts of successive rows in <data>
+//! \param compression_level - The zlib compression level, 0-9
+//! \param dpi - The resolution of the image, in pixels per inch
+
+void png_write_argb32(FILE *output, const unsigned char *data, int width, int height, int stride,
+                      int compression_level, double dpi) {
+    png_writer *writer = png_writer_open(output, width, height, compression_level, dpi);
+
+    // Work through the image in bands, to limit the size of the working buffers
+    for (int j = 0; j < height; j += PNG_BAND_ROWS) {
+        const int rows = (height - j < PNG_BAND_ROWS) ? height - j : PNG_BAND_ROWS;
+        png_writer_write_rows(writer, data + (size_t) j * stride, stride, rows);
+    }
+
+    png_writer_close(writer);
+}
@@ -0,0 +1,70 @@
+// pngWriter.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H 1
+
+#include <stdio.h>
+
+//! The number of bytes of filtered image data which are compressed by each thread as an independent deflate block
+#define PNG_CHUNK_SIZE 131072
+
+//! The size of the deflate sliding window, which is primed with the data preceding each chunk
+#define PNG_DICTIONARY_SIZE 32768
+
+//! The state of a PNG file which is being written, a band of rows at a time
+typedef struct {
+    //! The stream we are writing the PNG file to
+    FILE *output;
+
+    //! The dimensions of the image, in pixels
+    int width, height;
+
+    //! The zlib compression level, 0-9
+    int compression_level;
+
+    //! The number of rows of the image which have been written so far
+    int rows_written;
+
+    //! The number of bytes in each row of the PNG image, including the leading filter-type byte
+    int row_bytes;
+
+    //! The unpremultiplied RGBA pixels of the last row we wrote, used to filter the first row of the next band
+    unsigned char *previous_row;
+
+    //! The last <dictionary_length> bytes of filtered data we compressed, used to prime the next chunk
+    unsigned char dictionary[PNG_DICTIONARY_SIZE];
+    int dictionary_length;
+
+    //! Running Adler-32 checksum of all the filtered data we have compressed
+    unsigned long adler;
+} png_writer;
+
+png_writer *png_writer_open(FILE *output, int width, int height, int compression_level, double dpi);
+
+void png_writer_write_rows(png_writer *self, const unsigned char *data, int stride, int row_count);
+
+void png_writer_close(png_writer *self);
+
+void png_write_argb32(FILE *output, const unsigned char *data, int width, int height, int stride,
+                      int compression_level, double dpi);
+
+#endif
@@ -0,0 +1,212 @@
+// spriteAtlas.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// Raster output of large numbers of small filled circles, such as the stars on a deep star chart, is dominated by
+// the cost of cairo tessellating and rasterising each circle as a separate path. Instead we pre-render anti-aliased
+// discs for each radius bin and sub-pixel offset, and composite them straight into the pixels of the image surface.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cairo/cairo.h>
+#include <gsl/gsl_math.h>
+
+#include "coreUtils/errorReport.h"
+#include "settings/chart_config.h"
+
+#include "vectorGraphics/spriteAtlas.h"
+
+//! The number of radius bins in the atlas
+#define SPRITE_RADIUS_BINS (SPRITE_MAX_RADIUS * SPRITE_RADIUS_STEPS + 1)
+
+//! The total number of sprites in the atlas
+#define SPRITE_COUNT (SPRITE_RADIUS_BINS * SPRITE_SUBPIXEL_STEPS * SPRITE_SUBPIXEL_STEPS)
+
+//! sprite_atlas_create - Create an atlas of discs which are to be drawn onto a cairo ARGB32 image surface. The
+//! caller must flush the surface before drawing any discs, and mark it as dirty before drawing with cairo again.
+//! \param target - The image surface we are to draw onto
+//! \param colour - The colour of the discs to draw
+//! \return - A new sprite atlas, which should be freed with <sprite_atlas_destroy>
+
+sprite_atlas *sprite_atlas_create(cairo_surface_t *target, colour colour) {
+    sprite_atlas *self = (sprite_atlas *) malloc(sizeof(sprite_atlas));
+    if (self == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    self->target = target;
+    self->data = cairo_image_surface_get_data(target);
+    self->width = cairo_image_surface_get_width(target);
+    self->height = cairo_image_surface_get_height(target);
+    self->stride = cairo_image_surface_get_stride(target);
+
+    // Convert colour into an opaque ARGB32 pixel
+    const uint32_t red = (uint32_t) lround(gsl_max(0, gsl_min(1, colour.red)) * 255);
+    const uint32_t grn = (uint32_t) lround(gsl_max(0, gsl_min(1, colour.grn)) * 255);
+    const uint32_t blu = (uint32_t) lround(gsl_max(0, gsl_min(1, colour.blu)) * 255);
+    self->pixel = 0xFF000000u | (red << 16) | (grn << 8) | blu;
+
+    // Sprites are rendered the first time they are needed
+    self->sprites = (sprite *) calloc(SPRITE_COUNT, sizeof(sprite));
+    if (self->sprites == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    return self;
+}
+
+//! sprite_render - Compute the anti-aliased coverage of a disc
+//! \param out - The sprite to render
+//! \param radius - The radius of the disc, in pixels
+//! \param x_offset - The position of the centre of the disc within its central pixel, 0-1
+//! \param y_offset - The position of the centre of the disc within its central pixel, 0-1
+
+static void sprite_render(sprite *out, double radius, double x_offset, double y_offset) {
+    // The disc is centred in pixel <margin> of the sprite, and doesn't touch its edges
+    const int margin = (int) ceil(radius) + 1;
+    const int size = 2 * margin + 1;
+    const double x_centre = margin + x_offset;
+    const double y_centre = margin + y_offset;
+    const double radius_squared = radius * radius;
+
+    out->coverage = (unsigned char *) malloc((size_t) size * size);
+    if (out->coverage == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+
+    for (int j = 0; j < size; j++)
+        for (int i = 0; i < size; i++) {
+            int samples_inside = 0;
+            for (int b = 0; b < SPRITE_SUPERSAMPLING; b++) {
+                const double dy = j + (b + 0.5) / SPRITE_SUPERSAMPLING - y_centre;
+                for (int a = 0; a < SPRITE_SUPERSAMPLING; a++) {
+                    const double dx = i + (a + 0.5) / SPRITE_SUPERSAMPLING - x_centre;
+                    if (dx * dx + dy * dy <= radius_squared) samples_inside++;
+                }
+            }
+            const int sample_count = SPRITE_SUPERSAMPLING * SPRITE_SUPERSAMPLING;
+            out->coverage[j * size + i] = (unsigned char) ((samples_inside * 255 + sample_count / 2) / sample_count);
+        }
+
+    out->size = size;
+}
+
+//! pixel_multiply - Multiply all four 8-bit channels of an ARGB32 pixel by an alpha value, with correct rounding
+//! \param pixel - The pixel to multiply
+//! \param alpha - The alpha value to multiply by, 0-255
+//! \return - The product
+
+static inline uint32_t pixel_multiply(uint32_t pixel, uint32_t alpha) {
+    // Work on two channels at a time, each in a 16-bit lane of a 32-bit word
+    uint32_t rb = (pixel & 0x00FF00FFu) * alpha + 0x00800080u;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FFu)) >> 8) & 0x00FF00FFu;
+
+    uint32_t ag = ((pixel >> 8) & 0x00FF00FFu) * alpha + 0x00800080u;
+    ag = (ag + ((ag >> 8) & 0x00FF00FFu)) & 0xFF00FF00u;
+
+    return rb | ag;
+}
+
+//! composite_row - Composite one row of a sprite over a row of premultiplied ARGB32 pixels
+//! \param out - The row of destination pixels
+//! \param coverage - The coverage of each pixel by the sprite, 0-255
+//! \param pixel - The opaque colour of the sprite
+//! \param count - The number of pixels in the row
+
+static void composite_row(uint32_t *restrict out, const unsigned char *restrict coverage, uint32_t pixel,
+                          int count) {
+    for (int i = 0; i < count; i++) {
+        const uint32_t alpha = coverage[i];
+        // OVER operator: the sum of the two terms never exceeds 255 in any channel, so no carries occur
+        out[i] = pixel_multiply(pixel, alpha) + pixel_multiply(out[i], 255 - alpha);
+    }
+}
+
+//! sprite_atlas_draw_disc - Draw a filled disc onto the target surface, if it is small enough to be in the atlas
+//! \param self - The sprite atlas
+//! \param x - The x position of the centre of the disc, in pixels
+//! \param y - The y position of the centre of the disc, in pixels
+//! \param radius - The radius of the disc, in pixels
+//! \return - One if the disc was drawn; zero if it is too large, and must be drawn by the caller
+
+int sprite_atlas_draw_disc(sprite_atlas *self, double x, double y, double radius) {
+    if (!(radius <= SPRITE_MAX_RADIUS)) return 0;
+
+    // Work out which radius bin this disc falls into
+    int radius_bin = (int) lround(radius * SPRITE_RADIUS_STEPS);
+    if (radius_bin < 1) radius_bin = 1;
+
+    // Work out which pixel the centre of the disc falls into, and which sub-pixel offset within it
+    int x_pixel = (int) floor(x);
+    int y_pixel = (int) floor(y);
+    int x_step = (int) lround((x - x_pixel) * SPRITE_SUBPIXEL_STEPS);
+    int y_step = (int) lround((y - y_pixel) * SPRITE_SUBPIXEL_STEPS);
+    if (x_step == SPRITE_SUBPIXEL_STEPS) {
+        x_pixel++;
+        x_step = 0;
+    }
+    if (y_step == SPRITE_SUBPIXEL_STEPS) {
+        y_pixel++;
+        y_step = 0;
+    }
+
+    // Fetch the sprite, rendering it if this is the first time it has been used
+    sprite *item = &self->sprites[(radius_bin * SPRITE_SUBPIXEL_STEPS + y_step) * SPRITE_SUBPIXEL_STEPS + x_step];
+    if (item->size == 0) {
+        sprite_render(item, ((double) radius_bin) / SPRITE_RADIUS_STEPS,
+                      ((double) x_step) / SPRITE_SUBPIXEL_STEPS, ((double) y_step) / SPRITE_SUBPIXEL_STEPS);
+    }
+
+    // Position of the top-left corner of the sprite on the target surface
+    const int margin = item->size / 2;
+    const int x0 = x_pixel - margin;
+    const int y0 = y_pixel - margin;
+
+    // Clip the sprite to the edges of the target surface
+    const int i_min = (x0 < 0) ? -x0 : 0;
+    const int j_min = (y0 < 0) ? -y0 : 0;
+    const int i_max = (x0 + item->size > self->width) ? self->width - x0 : item->size;
+    const int j_max = (y0 + item->size > self->height) ? self->height - y0 : item->size;
+    if ((i_max <= i_min) || (j_max <= j_min)) return 1;
+
+    for (int j = j_min; j < j_max; j++) {
+        uint32_t *row = (uint32_t *) (self->data + (size_t) (y0 + j) * self->stride) + x0;
+        composite_row(row + i_min, item->coverage + j * item->size + i_min, self->pixel, i_max - i_min);
+    }
+
+    return 1;
+}
+
+//! sprite_atlas_destroy - Free a sprite atlas
+//! \param self - The sprite atlas to free
+
+void sprite_atlas_destroy(sprite_atlas *self) {
+    if (self == NULL) return;
+    for (int i = 0; i < SPRITE_COUNT; i++) free(self->sprites[i].coverage);
+    free(self->sprites);
+    free(self);
+}
@@ -0,0 +1,72 @@
+// spriteAtlas.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H 1
+
+#include <stdint.h>
+
+#include <cairo/cairo.h>
+
+#include "settings/chart_config.h"
+
+//! The number of sub-pixel positions, in each axis, at which we pre-render each disc
+#define SPRITE_SUBPIXEL_STEPS 4
+
+//! The number of radius bins per pixel of disc radius
+#define SPRITE_RADIUS_STEPS 8
+
+//! The largest disc radius, in pixels, which we draw from the atlas. Larger discs are drawn as vector paths.
+#define SPRITE_MAX_RADIUS 12
+
+//! The number of samples per pixel, in each axis, used to compute the anti-aliased coverage of each sprite
+#define SPRITE_SUPERSAMPLING 8
+
+//! A single pre-rendered anti-aliased disc
+typedef struct {
+    //! The width and height of the sprite, in pixels. Zero if this sprite has not been rendered yet.
+    int size;
+
+    //! The fraction of each pixel covered by the disc, 0-255
+    unsigned char *coverage;
+} sprite;
+
+//! A collection of anti-aliased discs, rendered on demand, which are composited directly into an ARGB32 image
+typedef struct {
+    //! The image surface we are drawing onto
+    cairo_surface_t *target;
+    unsigned char *data;
+    int width, height, stride;
+
+    //! The opaque colour of the discs, as a cairo ARGB32 pixel
+    uint32_t pixel;
+
+    //! Sprites, indexed by radius bin and then by sub-pixel offset in y and x
+    sprite *sprites;
+} sprite_atlas;
+
+sprite_atlas *sprite_atlas_create(cairo_surface_t *target, colour colour);
+
+int sprite_atlas_draw_disc(sprite_atlas *self, double x, double y, double radius);
+
+void sprite_atlas_destroy(sprite_atlas *self);
+
+#endif
@@ -0,0 +1,648 @@
+// svgWriter.c
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+// A compact SVG writer for the primitives which make up the bulk of a star chart. Cairo writes every star as a full
+// Bezier path and every character of text as a glyph outline. Instead, the stars and text labels on a chart are
+// stored in an <svg_layer>, and written as <use> references to a small number of <symbol> elements and as <text>
+// elements, which are styled by a stylesheet. All other graphics are rendered by cairo's own SVG surface, and the two
+// are spliced together into a single document. For other output formats, the layer is simply replayed through cairo.
+//
+// To preserve the order in which the chart is painted, cairo draws through an observer surface, which tells us
+// whenever cairo paints anything. When an item is added to the layer after cairo has painted, the cairo recording so
+// far is closed off into a segment, and cairo starts afresh. The chart is output by painting each segment's cairo
+// recording followed by its items.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <cairo/cairo.h>
+#include <cairo/cairo-svg.h>
+
+#include <gsl/gsl_math.h>
+
+#include "coreUtils/errorReport.h"
+
+#include "vectorGraphics/svgWriter.h"
+
+//! A growable buffer of bytes, into which cairo writes an SVG document
+typedef struct {
+    char *data;
+    long length, allocated;
+} svg_buffer;
+
+//! svg_grow - Ensure that a malloced array has space for at least <required> elements, growing it if needed
+//! \param array - Pointer to the array
+//! \param allocated - Pointer to the number of elements allocated in the array
+//! \param required - The number of elements required
+//! \param element_size - The size of each element, bytes
+
+static void svg_grow(void **array, long *allocated, long required, size_t element_size) {
+    if (required <= *allocated) return;
+    long new_size = (*allocated > 0) ? *allocated : 1024;
+    while (new_size < required) new_size *= 2;
+    void *new_array = realloc(*array, new_size * element_size);
+    if (new_array == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+    *array = new_array;
+    *allocated = new_size;
+}
+
+//! svg_pack_colour - Pack a colour into an integer, with eight bits per channel
+//! \param red - The red component, 0-1
+//! \param grn - The green component, 0-1
+//! \param blu - The blue component, 0-1
+//! \param alpha - The opacity, 0-1
+//! \return - The packed colour
+
+static unsigned long svg_pack_colour(double red, double grn, double blu, double alpha) {
+    const double channels[4] = {red, grn, blu, alpha};
+    unsigned long out = 0;
+    for (int i = 0; i < 4; i++) {
+        double c = channels[i];
+        if (!(c > 0)) c = 0;
+        if (c > 1) c = 1;
+        out = (out << 8) | (unsigned long) lround(c * 255);
+    }
+    return out;
+}
+
+//! svg_layer_create - Create a new empty layer of native SVG primitives
+//! \return - The new layer, which should be freed with <svg_layer_destroy>
+
+svg_layer *svg_layer_create() {
+    svg_layer *self = (svg_layer *) calloc(1, sizeof(svg_layer));
+    if (self == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+    return self;
+}
+
+//! svg_layer_destroy - Free a layer of native SVG primitives
+//! \param self - The layer to free
+
+void svg_layer_destroy(svg_layer *self) {
+    if (self == NULL) return;
+    for (long i = 0; i < self->segment_count; i++) cairo_surface_destroy(self->segments[i].recording);
+    if (self->observer != NULL) cairo_surface_destroy(self->observer);
+    free(self->segments);
+    free(self->items);
+    free(self->strings);
+    free(self);
+}
+
+//! svg_layer_cairo_drawn - Callback used by the observer surface to tell us that cairo has painted something
+//! \param observer - The observer surface
+//! \param target - The recording surface which cairo is painting onto
+//! \param data - The <svg_layer> which cairo is drawing alongside
+
+static void svg_layer_cairo_drawn(cairo_surface_t *observer, cairo_surface_t *target, void *data) {
+    ((svg_layer *) data)->cairo_drawn = 1;
+}
+
+//! svg_layer_attach - Attach a layer to the cairo recording surface onto which the rest of a star chart is drawn
+//! \param self - The layer to attach
+//! \param recording - The recording surface onto which cairo is to draw
+//! \return - The surface which cairo should draw onto, in place of <recording>. This is owned by the layer.
+
+cairo_surface_t *svg_layer_attach(svg_layer *self, cairo_surface_t *recording) {
+    self->recording = recording;
+    self->observer = cairo_surface_create_observer(recording, CAIRO_SURFACE_OBSERVER_NORMAL);
+    cairo_surface_observer_add_paint_callback(self->observer, svg_layer_cairo_drawn, self);
+    cairo_surface_observer_add_mask_callback(self->observer, svg_layer_cairo_drawn, self);
+    cairo_surface_observer_add_fill_callback(self->observer, svg_layer_cairo_drawn, self);
+    cairo_surface_observer_add_stroke_callback(self->observer, svg_layer_cairo_drawn, self);
+    cairo_surface_observer_add_glyphs_callback(self->observer, svg_layer_cairo_drawn, self);
+    return self->observer;
+}
+
+//! svg_layer_flush - Close off everything cairo has painted since the last segment into a new segment, and clear
+//! the recording surface that cairo draws onto, so that it starts afresh
+//! \param self - The layer whose cairo recording we are to close off
+
+static void svg_layer_flush(svg_layer *self) {
+    svg_grow((void **) &self->segments, &self->segment_allocated, self->segment_count + 1, sizeof(svg_segment));
+    svg_segment *segment = &self->segments[self->segment_count++];
+
+    // Copy the graphics recorded so far onto a new recording surface. Cairo snapshots the source surface, so the
+    // copy is unaffected when we clear it below.
+    cairo_rectangle_t extents;
+    cairo_recording_surface_get_extents(self->recording, &extents);
+    segment->recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    segment->first_item = self->item_count;
+    cairo_t *copy = cairo_create(segment->recording);
+    cairo_set_source_surface(copy, self->recording, 0, 0);
+    cairo_paint(copy);
+    cairo_destroy(copy);
+
+    // Clear the recording surface. This bypasses the observer, since it is not part of the chart.
+    cairo_t *clear = cairo_create(self->recording);
+    cairo_set_operator(clear, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(clear);
+    cairo_destroy(clear);
+
+    self->cairo_drawn = 0;
+}
+
+//! svg_layer_finish - Close off the final segment of a star chart, once cairo has finished drawing it
+//! \param self - The layer to finish
+
+void svg_layer_finish(svg_layer *self) {
+    svg_layer_flush(self);
+    cairo_surface_finish(self->observer);
+}
+
+//! svg_layer_new_item - Append a new item to a layer. If cairo has painted anything since the previous item, a new
+//! segment is started, so that the new item is painted on top of it.
+//! \param self - The layer to append to
+//! \param type - The type of the item, e.g. SVG_ITEM_CIRCLE
+//! \return - Pointer to the new item
+
+static svg_item *svg_layer_new_item(svg_layer *self, int type) {
+    if (self->cairo_drawn || (self->segment_count == 0)) svg_layer_flush(self);
+    svg_grow((void **) &self->items, &self->item_allocated, self->item_count + 1, sizeof(svg_item));
+    svg_item *item = &self->items[self->item_count++];
+    memset(item, 0, sizeof(svg_item));
+    item->type = type;
+    item->clipped = self->clip_active;
+    return item;
+}
+
+//! svg_layer_circle - Add a filled circle to a layer
+//! \param self - The layer to draw onto
+//! \param x - The x position of the centre of the circle (canvas coordinates)
+//! \param y - The y position of the centre of the circle (canvas coordinates)
+//! \param radius - The radius of the circle (canvas coordinates)
+//! \param red - The red component of the colour of the circle, 0-1
+//! \param grn - The green component of the colour of the circle, 0-1
+//! \param blu - The blue component of the colour of the circle, 0-1
+
+void svg_layer_circle(svg_layer *self, double x, double y, double radius, double red, double grn, double blu) {
+    svg_item *item = svg_layer_new_item(self, SVG_ITEM_CIRCLE);
+    item->colour = svg_pack_colour(red, grn, blu, 1);
+    item->x = x;
+    item->y = y;
+    item->radius = radius;
+}
+
+//! svg_layer_text - Add a text string to a layer, in place of calling <cairo_show_text>. The position, font, colour
+//! and transformation of the text are taken from the current state of a cairo drawing context, and the current point
+//! is advanced past the end of the string, as cairo would.
+//! \param self - The layer to draw onto
+//! \param cairo_draw - The cairo drawing context whose state defines the appearance of the text
+//! \param text - The string to write
+
+void svg_layer_text(svg_layer *self, cairo_t *cairo_draw, const char *text) {
+    svg_item *item = svg_layer_new_item(self, SVG_ITEM_TEXT);
+
+    // Position and transformation of the text
+    cairo_get_current_point(cairo_draw, &item->x, &item->y);
+    cairo_get_matrix(cairo_draw, &item->matrix);
+
+    // Colour of the text
+    double red = 0, grn = 0, blu = 0, alpha = 1;
+    cairo_pattern_get_rgba(cairo_get_source(cairo_draw), &red, &grn, &blu, &alpha);
+    item->colour = svg_pack_colour(red, grn, blu, alpha);
+
+    // Font of the text
+    cairo_matrix_t font_matrix;
+    cairo_get_font_matrix(cairo_draw, &font_matrix);
+    item->font_size = font_matrix.yy;
+
+    cairo_font_face_t *face = cairo_get_font_face(cairo_draw);
+    svg_font font;
+    snprintf(font.family, sizeof(font.family), "%s", cairo_toy_font_face_get_family(face));
+    font.slant = cairo_toy_font_face_get_slant(face);
+    font.weight = cairo_toy_font_face_get_weight(face);
+
+    item->font = -1;
+    for (int i = 0; i < self->font_count; i++) {
+        if ((strcmp(self->fonts[i].family, font.family) == 0) && (self->fonts[i].slant == font.slant) &&
+            (self->fonts[i].weight == font.weight)) {
+            item->font = i;
+            break;
+        }
+    }
+    if (item->font < 0) {
+        if (self->font_count >= SVG_MAX_FONTS) {
+            stch_fatal(__FILE__, __LINE__, "Too many fonts used in a single chart.");
+            exit(1);
+        }
+        item->font = self->font_count;
+        self->fonts[self->font_count++] = font;
+    }
+
+    // Copy the text into the string store
+    const long length = (long) strlen(text) + 1;
+    svg_grow((void **) &self->strings, &self->strings_allocated, self->strings_used + length, 1);
+    memcpy(self->strings + self->strings_used, text, length);
+    item->text = self->strings_used;
+    self->strings_used += length;
+
+    // Advance the current point past the end of the text, as <cairo_show_text> would do
+    cairo_text_extents_t extents;
+    cairo_text_extents(cairo_draw, text, &extents);
+    cairo_move_to(cairo_draw, item->x + extents.x_advance, item->y + extents.y_advance);
+}
+
+//! svg_layer_clip_path - Add the outline of the plot area, to which items may be clipped, to a cairo path
+//! \param self - The layer whose clip region we are to draw
+//! \param cairo_draw - The cairo drawing context to add the path to
+
+static void svg_layer_clip_path(const svg_layer *self, cairo_t *cairo_draw) {
+    cairo_new_path(cairo_draw);
+    if (self->clip_radius > 0) {
+        cairo_arc(cairo_draw, self->clip_x, self->clip_y, self->clip_radius, 0, 2 * M_PI);
+    } else {
+        cairo_rectangle(cairo_draw, self->clip_x, self->clip_y, self->clip_width, self->clip_height);
+    }
+}
+
+//! svg_layer_segment_end - Find the index of the item after the last one in a segment
+//! \param self - The layer the segment belongs to
+//! \param segment - The index of the segment
+//! \return - The index of the item after the last one in the segment
+
+static long svg_layer_segment_end(const svg_layer *self, long segment) {
+    return (segment + 1 < self->segment_count) ? self->segments[segment + 1].first_item : self->item_count;
+}
+
+//! svg_layer_replay_items - Draw a run of items in a layer onto a cairo drawing context
+//! \param self - The layer to draw
+//! \param cairo_draw - The cairo drawing context to draw onto
+//! \param first - The index of the first item to draw
+//! \param end - The index of the item after the last one to draw
+
+static void svg_layer_replay_items(const svg_layer *self, cairo_t *cairo_draw, long first, long end) {
+    for (long i = first; i < end; i++) {
+        const svg_item *item = &self->items[i];
+
+        cairo_save(cairo_draw);
+        if (item->clipped) {
+            svg_layer_clip_path(self, cairo_draw);
+            cairo_clip(cairo_draw);
+        }
+
+        const unsigned long c = item->colour;
+        cairo_set_source_rgba(cairo_draw, ((c >> 24) & 255) / 255., ((c >> 16) & 255) / 255.,
+                              ((c >> 8) & 255) / 255., (c & 255) / 255.);
+
+        if (item->type == SVG_ITEM_CIRCLE) {
+            // Accumulate a run of circles which share the same colour and clipping into a single path
+            cairo_new_path(cairo_draw);
+            for (; ; i++) {
+                cairo_new_sub_path(cairo_draw);
+                cairo_arc(cairo_draw, self->items[i].x, self->items[i].y, self->items[i].radius, 0, 2 * M_PI);
+                const svg_item *next = (i + 1 < end) ? &self->items[i + 1] : NULL;
+                if ((next == NULL) || (next->type != SVG_ITEM_CIRCLE) || (next->colour != item->colour) ||
+                    (next->clipped != item->clipped))
+                    break;
+            }
+            cairo_fill(cairo_draw);
+        } else {
+            const svg_font *font = &self->fonts[item->font];
+            cairo_transform(cairo_draw, &item->matrix);
+            cairo_select_font_face(cairo_draw, font->family, font->slant, font->weight);
+            cairo_set_font_size(cairo_draw, item->font_size);
+            cairo_move_to(cairo_draw, item->x, item->y);
+            cairo_show_text(cairo_draw, self->strings + item->text);
+        }
+
+        cairo_restore(cairo_draw);
+    }
+}
+
+//! svg_layer_replay - Draw a star chart, consisting of the segments of cairo graphics interleaved with the items in a
+//! layer, onto a cairo drawing context, for output formats other than SVG
+//! \param self - The layer to draw
+//! \param cairo_draw - The cairo drawing context to draw onto. Its transformation should map canvas coordinates onto
+//! the output surface.
+
+void svg_layer_replay(const svg_layer *self, cairo_t *cairo_draw) {
+    for (long i = 0; i < self->segment_count; i++) {
+        cairo_set_source_surface(cairo_draw, self->segments[i].recording, 0, 0);
+        cairo_paint(cairo_draw);
+        svg_layer_replay_items(self, cairo_draw, self->segments[i].first_item, svg_layer_segment_end(self, i));
+    }
+}
+
+//! svg_number - Format a number compactly, with a fixed number of decimal places but no trailing zeros
+//! \param out - Character buffer, of length at least 32, into which to write the number
+//! \param value - The number to format
+//! \param decimal_places - The number of decimal places to write
+//! \return - <out>
+
+static char *svg_number(char *out, double value, int decimal_places) {
+    snprintf(out, 32, "%.*f", decimal_places, value);
+    char *end = out + strlen(out) - 1;
+    while (*end == '0') *(end--) = '\0';
+    if (*end == '.') *end = '\0';
+    if (strcmp(out, "-0") == 0) strcpy(out, "0");
+    return out;
+}
+
+//! svg_write_escaped - Write a string to an SVG file, escaping XML special characters
+//! \param output - The stream to write to
+//! \param text - The string to write
+
+static void svg_write_escaped(FILE *output, const char *text) {
+    for (; *text != '\0'; text++) {
+        switch (*text) {
+            case '&':
+                fputs("&amp;", output);
+                break;
+            case '<':
+                fputs("&lt;", output);
+                break;
+            case '>':
+                fputs("&gt;", output);
+                break;
+            default:
+                fputc(*text, output);
+        }
+    }
+}
+
+//! svg_append_to_buffer - Callback used by cairo to write an SVG document into memory
+//! \param closure - The <svg_buffer> to write to
+//! \param data - The bytes to write
+//! \param length - The number of bytes to write
+//! \return - Cairo status code
+
+static cairo_status_t svg_append_to_buffer(void *closure, const unsigned char *data, unsigned int length) {
+    svg_buffer *buffer = (svg_buffer *) closure;
+    svg_grow((void **) &buffer->data, &buffer->allocated, buffer->length + length + 1, 1);
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return CAIRO_STATUS_SUCCESS;
+}
+
+//! compare_long - Comparison function for sorting arrays of longs with qsort
+//! \param a - Pointer to the first long
+//! \param b - Pointer to the second long
+//! \return - strcmp-like comparison of the two values
+
+static int compare_long(const void *a, const void *b) {
+    const long x = *(const long *) a, y = *(const long *) b;
+    return (x > y) - (x < y);
+}
+
+//! svg_colour_index - Look up the index of a colour in a table of colours, adding it if it is not already present
+//! \param colours - The table of colours
+//! \param colour_count - The number of colours in the table
+//! \param colours_allocated - The number of entries allocated in the table
+//! \param colour - The colour to look up
+//! \return - The index of the colour in the table
+
+static int svg_colour_index(unsigned long **colours, long *colour_count, long *colours_allocated,
+                            unsigned long colour) {
+    for (long i = 0; i < *colour_count; i++) if ((*colours)[i] == colour) return (int) i;
+    svg_grow((void **) colours, colours_allocated, *colour_count + 1, sizeof(unsigned long));
+    (*colours)[*colour_count] = colour;
+    return (int) (*colour_count)++;
+}
+
+//! svg_render_segment - Render the cairo recording of one segment of a star chart as an SVG document, in memory
+//! \param segment - The segment to render
+//! \param width - The width of the SVG document (points)
+//! \param height - The height of the SVG document (points)
+//! \param scale - The number of points per unit of the recording surface
+//! \param [out] document - The buffer to write the SVG document into
+//! \param [out] body_start - Set to point to the start of the document's content, after its opening <svg> tag
+//! \param [out] body_end - Set to point to the document's closing </svg> tag
+
+static void svg_render_segment(const svg_segment *segment, double width, double height, double scale,
+                               svg_buffer *document, const char **body_start, const char **body_end) {
+    document->data = NULL;
+    document->length = document->allocated = 0;
+
+    cairo_surface_t *surface = cairo_svg_surface_create_for_stream(svg_append_to_buffer, document, width, height);
+    cairo_t *replay = cairo_create(surface);
+    cairo_scale(replay, scale, scale);
+    cairo_set_source_surface(replay, segment->recording, 0, 0);
+    cairo_paint(replay);
+    cairo_destroy(replay);
+    cairo_surface_finish(surface);
+    cairo_surface_destroy(surface);
+
+    // Find the end of the opening <svg> tag, and the start of the closing one
+    const char *svg_start = (document->data == NULL) ? NULL : strstr(document->data, "<svg");
+    const char *svg_open_end = (svg_start == NULL) ? NULL : strchr(svg_start, '>');
+    const char *svg_close = NULL;
+    for (const char *scan = svg_open_end; (scan != NULL) && ((scan = strstr(scan, "</svg>")) != NULL); scan++) {
+        svg_close = scan;
+    }
+    if (svg_close == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Could not parse the SVG document produced by cairo.");
+        exit(1);
+    }
+    *body_start = svg_open_end + 1;
+    *body_end = svg_close;
+}
+
+//! svg_write_prefixed - Copy the content of an SVG document produced by cairo into our output, prefixing every id it
+//! defines or references, so that ids from the documents of different segments don't collide
+//! \param output - The stream to write to
+//! \param start - The start of the content to copy
+//! \param end - The end of the content to copy
+//! \param segment - The index of the segment, used to construct the prefix
+
+static void svg_write_prefixed(FILE *output, const char *start, const char *end, long segment) {
+    static const char *patterns[] = {"id=\"", "href=\"#", "url(#"};
+    while (start < end) {
+        // Find the next place where an id is defined or referenced
+        const char *match = end;
+        size_t match_length = 0;
+        for (int i = 0; i < 3; i++) {
+            const size_t length = strlen(patterns[i]);
+            for (const char *scan = start; scan + length <= match; scan++) {
+                if (strncmp(scan, patterns[i], length) == 0) {
+                    match = scan;
+                    match_length = length;
+                    break;
+                }
+            }
+        }
+
+        // Copy the text up to and including the pattern, and then write the prefix
+        fwrite(start, 1, match - start + match_length, output);
+        if (match < end) fprintf(output, "s%ld-", segment);
+        start = match + match_length;
+    }
+}
+
+//! svg_write_items - Write a run of items in a layer as native SVG elements, grouping runs of items which share the
+//! same colour and clipping
+//! \param self - The layer of native primitives
+//! \param output - The stream to write to
+//! \param first - The index of the first item to write
+//! \param end - The index of the item after the last one to write
+//! \param colours - The table of colours used in the stylesheet
+//! \param colour_count - The number of colours in <colours>
+//! \param radii - Sorted list of the radii of the circle symbols, in units of 0.01 pt
+//! \param radius_count - The number of entries in <radii>
+//! \param scale - The number of points per unit of the recording surface
+
+static void svg_write_items(const svg_layer *self, FILE *output, long first, long end, unsigned long *colours,
+                            long colour_count, const long *radii, long radius_count, double scale) {
+    char n1[32], n2[32], n3[32], n4[32], n5[32], n6[32], n7[32], n8[32], n9[32];
+    long colours_allocated = colour_count;
+
+    for (long i = first; i < end;) {
+        const svg_item *first_item = &self->items[i];
+        fprintf(output, "<g class=\"sc-c%d\"%s>\n",
+                svg_colour_index(&colours, &colour_count, &colours_allocated, first_item->colour),
+                first_item->clipped ? " clip-path=\"url(#sc-plot)\"" : "");
+
+        for (; (i < end) && (self->items[i].colour == first_item->colour) &&
+               (self->items[i].clipped == first_item->clipped); i++) {
+            const svg_item *item = &self->items[i];
+            if (item->type == SVG_ITEM_CIRCLE) {
+                const long radius = lround(item->radius * scale * 100);
+                const long *symbol = (const long *) bsearch(&radius, radii, radius_count, sizeof(long), compare_long);
+                fprintf(output, "<use xlink:href=\"#sc-d%ld\" x=\"%s\" y=\"%s\"/>\n", (long) (symbol - radii),
+                        svg_number(n1, item->x * scale, 2), svg_number(n2, item->y * scale, 2));
+            } else {
+                const cairo_matrix_t *m = &item->matrix;
+                if ((m->xx == 1) && (m->yy == 1) && (m->xy == 0) && (m->yx == 0)) {
+                    // Text with no rotation can be positioned directly
+                    fprintf(output, "<text class=\"sc-f%d\" x=\"%s\" y=\"%s\" font-size=\"%s\">", item->font,
+                            svg_number(n1, (item->x + m->x0) * scale, 2),
+                            svg_number(n2, (item->y + m->y0) * scale, 2),
+                            svg_number(n3, item->font_size * scale, 2));
+                } else {
+                    fprintf(output, "<text class=\"sc-f%d\" transform=\"matrix(%s %s %s %s %s %s)\" x=\"%s\" "
+                                    "y=\"%s\" font-size=\"%s\">", item->font,
+                            svg_number(n1, m->xx * scale, 4), svg_number(n2, m->yx * scale, 4),
+                            svg_number(n3, m->xy * scale, 4), svg_number(n4, m->yy * scale, 4),
+                            svg_number(n5, m->x0 * scale, 2), svg_number(n6, m->y0 * scale, 2),
+                            svg_number(n7, item->x, 2), svg_number(n8, item->y, 2),
+                            svg_number(n9, item->font_size, 2));
+                }
+                svg_write_escaped(output, self->strings + item->text);
+                fprintf(output, "</text>\n");
+            }
+        }
+        fprintf(output, "</g>\n");
+    }
+}
+
+//! svg_layer_write - Write an SVG file, containing the segments of a star chart rendered by cairo, interleaved with
+//! the items in a layer of native SVG primitives. <svg_layer_finish> must have been called first.
+//! \param self - The layer of native primitives
+//! \param output - The stream to write the SVG file to
+//! \param width - The width of the SVG document (points)
+//! \param height - The height of the SVG document (points)
+//! \param scale - The number of points per unit of the recording surface
+
+void svg_layer_write(const svg_layer *self, FILE *output, double width, double height, double scale) {
+    char n1[32], n2[32], n3[32], n4[32];
+
+    // Build a stylesheet of all the colours used in the layer
+    unsigned long *colours = NULL;
+    long colour_count = 0, colours_allocated = 0;
+    for (long i = 0; i < self->item_count; i++) {
+        svg_colour_index(&colours, &colour_count, &colours_allocated, self->items[i].colour);
+    }
+
+    // Make a sorted list of all the distinct circle radii, each of which becomes a symbol, to 0.01 pt precision
+    long *radii = (long *) malloc((self->item_count + 1) * sizeof(long));
+    long radius_count = 0;
+    if (radii == NULL) {
+        stch_fatal(__FILE__, __LINE__, "Malloc fail.");
+        exit(1);
+    }
+    for (long i = 0; i < self->item_count; i++) {
+        if (self->items[i].type == SVG_ITEM_CIRCLE) radii[radius_count++] = lround(self->items[i].radius * scale * 100);
+    }
+    qsort(radii, radius_count, sizeof(long), compare_long);
+    {
+        long j = 0;
+        for (long i = 0; i < radius_count; i++) if ((j == 0) || (radii[i] != radii[j - 1])) radii[j++] = radii[i];
+        radius_count = j;
+    }
+
+    for (long segment = 0; segment < self->segment_count; segment++) {
+        // Render the graphics in this segment which aren't in the layer using cairo's SVG surface
+        svg_buffer cairo_svg;
+        const char *body_start, *body_end;
+        svg_render_segment(&self->segments[segment], width, height, scale, &cairo_svg, &body_start, &body_end);
+
+        if (segment == 0) {
+            // Copy the header of cairo's document
+            fwrite(cairo_svg.data, 1, body_start - cairo_svg.data, output);
+
+            // Write stylesheet
+            fprintf(output, "\n<style>\n");
+            for (long i = 0; i < colour_count; i++) {
+                const unsigned long c = colours[i];
+                fprintf(output, ".sc-c%ld{fill:#%02lx%02lx%02lx", i, (c >> 24) & 255, (c >> 16) & 255,
+                        (c >> 8) & 255);
+                if ((c & 255) != 255) fprintf(output, ";fill-opacity:%s", svg_number(n1, (c & 255) / 255., 3));
+                fprintf(output, "}\n");
+            }
+            for (int i = 0; i < self->font_count; i++) {
+                fprintf(output, ".sc-f%d{font-family:'", i);
+                svg_write_escaped(output, self->fonts[i].family);
+                fprintf(output, "'%s%s}\n",
+                        (self->fonts[i].weight == CAIRO_FONT_WEIGHT_BOLD) ? ";font-weight:bold" : "",
+                        (self->fonts[i].slant == CAIRO_FONT_SLANT_ITALIC) ? ";font-style:italic" :
+                        (self->fonts[i].slant == CAIRO_FONT_SLANT_OBLIQUE) ? ";font-style:oblique" : "");
+            }
+            fprintf(output, "</style>\n");
+
+            // Write definitions of the clip region and the symbols for circles
+            fprintf(output, "<defs>\n<clipPath id=\"sc-plot\">");
+            if (self->clip_radius > 0) {
+                fprintf(output, "<circle cx=\"%s\" cy=\"%s\" r=\"%s\"/>", svg_number(n1, self->clip_x * scale, 2),
+                        svg_number(n2, self->clip_y * scale, 2), svg_number(n3, self->clip_radius * scale, 2));
+            } else {
+                fprintf(output, "<rect x=\"%s\" y=\"%s\" width=\"%s\" height=\"%s\"/>",
+                        svg_number(n1, self->clip_x * scale, 2), svg_number(n2, self->clip_y * scale, 2),
+                        svg_number(n3, self->clip_width * scale, 2), svg_number(n4, self->clip_height * scale, 2));
+            }
+            fprintf(output, "</clipPath>\n");
+            for (long i = 0; i < radius_count; i++) {
+                fprintf(output, "<symbol id=\"sc-d%ld\" overflow=\"visible\"><circle r=\"%s\"/></symbol>\n",
+                        i, svg_number(n1, radii[i] / 100., 2));
+            }
+            fprintf(output, "</defs>\n");
+        }
+
+        // Copy the body of cairo's document, followed by the items in this segment
+        svg_write_prefixed(output, body_start, body_end, segment);
+        svg_write_items(self, output, self->segments[segment].first_item, svg_layer_segment_end(self, segment),
+                        colours, colour_count, radii, radius_count, scale);
+
+        // After the last segment, copy the closing tag of cairo's document
+        if (segment == self->segment_count - 1) fputs(body_end, output);
+
+        free(cairo_svg.data);
+    }
+
+    free(radii);
+    free(colours);
+}
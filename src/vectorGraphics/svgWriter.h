@@ -0,0 +1,131 @@
+// svgWriter.h
+//
+// -------------------------------------------------
+// Copyright 2015-2022 Dominic Ford
+//
+// This file is part of StarCharter.
+//
+// StarCharter is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// StarCharter is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with StarCharter.  If not, see <http://www.gnu.org/licenses/>.
+// -------------------------------------------------
+
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H 1
+
+#include <stdio.h>
+
+#include <cairo/cairo.h>
+
+//! Types of primitive which may be stored in an <svg_layer>
+#define SVG_ITEM_CIRCLE 1
+#define SVG_ITEM_TEXT 2
+
+//! The maximum number of distinct fonts which may be used within an <svg_layer>
+#define SVG_MAX_FONTS 16
+
+//! A single primitive drawn onto an <svg_layer>
+typedef struct {
+    //! One of SVG_ITEM_CIRCLE or SVG_ITEM_TEXT
+    int type;
+
+    //! Boolean flag indicating whether this item is clipped to the plot area
+    int clipped;
+
+    //! The colour of this item, as 8-bit RGBA values packed into an integer
+    unsigned long colour;
+
+    //! The centre of a circle, or the position of the start of the baseline of a text string (user coordinates)
+    double x, y;
+
+    //! The radius of a circle
+    double radius;
+
+    //! The transformation matrix from user coordinates to canvas coordinates for a text string
+    cairo_matrix_t matrix;
+
+    //! The font size of a text string, and the index of its font in the <svg_layer> font table
+    double font_size;
+    int font;
+
+    //! The offset of a text string in the <svg_layer> string store
+    long text;
+} svg_item;
+
+//! A portion of a star chart, consisting of graphics rendered by cairo followed by a run of items in an <svg_layer>.
+//! Splitting the chart into segments preserves the order in which items were painted.
+typedef struct {
+    //! A cairo recording of the graphics painted before the items in this segment
+    cairo_surface_t *recording;
+
+    //! The index of the first item in this segment. The segment ends where the next one begins.
+    long first_item;
+} svg_segment;
+
+//! A font used by text within an <svg_layer>
+typedef struct {
+    char family[64];
+    cairo_font_slant_t slant;
+    cairo_font_weight_t weight;
+} svg_font;
+
+//! A layer of circles and text which is interleaved with the cairo rendering of a star chart. In SVG output these
+//! are written as native SVG elements, which are much more compact than the paths which cairo produces.
+typedef struct svg_layer {
+    //! The primitives drawn onto this layer, in order
+    svg_item *items;
+    long item_count, item_allocated;
+
+    //! The segments which the chart has been divided into, in painting order
+    svg_segment *segments;
+    long segment_count, segment_allocated;
+
+    //! The recording surface onto which cairo is drawing the current segment, and an observer surface wrapping it,
+    //! which cairo draws through so that we can tell when it has painted anything
+    cairo_surface_t *recording, *observer;
+
+    //! Boolean flag indicating whether cairo has painted anything since the last item was added to this layer
+    int cairo_drawn;
+
+    //! Storage for the text strings within this layer
+    char *strings;
+    long strings_used, strings_allocated;
+
+    //! The fonts used by text within this layer
+    svg_font fonts[SVG_MAX_FONTS];
+    int font_count;
+
+    //! Boolean flag indicating whether new items are clipped to the plot area
+    int clip_active;
+
+    //! The plot area to which items are clipped: either a circle of radius <clip_radius> centred at
+    //! (<clip_x>, <clip_y>), or if <clip_radius> is zero, a rectangle of size <clip_width> x <clip_height>
+    double clip_x, clip_y, clip_radius, clip_width, clip_height;
+} svg_layer;
+
+svg_layer *svg_layer_create();
+
+void svg_layer_destroy(svg_layer *self);
+
+cairo_surface_t *svg_layer_attach(svg_layer *self, cairo_surface_t *recording);
+
+void svg_layer_finish(svg_layer *self);
+
+void svg_layer_circle(svg_layer *self, double x, double y, double radius, double red, double grn, double blu);
+
+void svg_layer_text(svg_layer *self, cairo_t *cairo_draw, const char *text);
+
+void svg_layer_replay(const svg_layer *self, cairo_t *cairo_draw);
+
+void svg_layer_write(const svg_layer *self, FILE *output, double width, double height, double scale);
+
+#endif